@@ -1,13 +1,33 @@
 //default grid fragment shader
 
-#version 330 core
+#version 460 core
 
-uniform vec3 u_color; //grid color
-uniform float u_alpha; //grid opacity
+//std430 layout, matches RenderQueue::ObjectData
+struct Object {
+    mat4 model_transform; //model matrix
+    vec3 color; //color
+    float alpha; //opacity
+    vec2 texture_tiling; //texture (uv) tiling
+    float texture_influence; //are textures enabled?
+    int shininess; //material shininess
+    bool instanced; //is the model matrix combined with a per-instance matrix?
+    bool use_color_palette; //is the color picked in the palette by the material id instead?
+    int texture_layer; //layer of the texture in its array, -1 if it isn't loaded
+    float texture_max_lod; //last mip level of the texture in its layer
+    vec2 texture_scale; //part of the layer covered by the texture
+    vec3 color_palette[8]; //colors of the baked meshes' pieces, matches Shader::MAX_COLOR_PALETTE_SIZE
+};
+
+//per draw, streamed once per frame, indexed by the draw's position in its multi-draw (gl_DrawID)
+layout (std430) readonly buffer ObjectBlock {
+    Object u_objects[];
+};
+
+flat in int ObjectId; //index of the draw in the storage block
 
 layout(location = 0) out vec4 out_color; //rgba color output
 
 //entrypoint
 void main() {
-    out_color = vec4(u_color, u_alpha);
+    out_color = vec4(u_objects[ObjectId].color, u_objects[ObjectId].alpha);
 }
\ No newline at end of file
@@ -1,12 +1,42 @@
 //default line vertex shader
 
-#version 330 core
+#version 460 core
 
-uniform mat4 u_model_transform; //model matrix
-uniform mat4 u_view_projection; //view projection matrix
+//std430 layout, matches RenderQueue::ObjectData
+struct Object {
+    mat4 model_transform; //model matrix
+    vec3 color; //color
+    float alpha; //opacity
+    vec2 texture_tiling; //texture (uv) tiling
+    float texture_influence; //are textures enabled?
+    int shininess; //material shininess
+    bool instanced; //is the model matrix combined with a per-instance matrix?
+    bool use_color_palette; //is the color picked in the palette by the material id instead?
+    int texture_layer; //layer of the texture in its array, -1 if it isn't loaded
+    float texture_max_lod; //last mip level of the texture in its layer
+    vec2 texture_scale; //part of the layer covered by the texture
+    vec3 color_palette[8]; //colors of the baked meshes' pieces, matches Shader::MAX_COLOR_PALETTE_SIZE
+};
+
+//per draw, streamed once per frame, indexed by the draw's position in its multi-draw (gl_DrawID)
+layout (std430) readonly buffer ObjectBlock {
+    Object u_objects[];
+};
+
+//shared by all programs, written once per pass
+layout (std140) uniform ViewBlock {
+    mat4 u_view; //view matrix
+    mat4 u_projection; //projection matrix
+    mat4 u_view_projection; //view projection matrix
+    vec3 u_cam_pos; //cam position
+};
 
 layout (location = 0) in vec3 vPos; //vertex input position
 
+flat out int ObjectId; //index of the draw in the storage block, for the fragment shader
+
 void main() {
-    gl_Position = u_view_projection * u_model_transform * vec4(vPos, 1.0); //gl_Position is a built-in property of a vertex shader
+    ObjectId = gl_DrawID; //position of the draw in its multi-draw (0 for regular draws)
+
+    gl_Position = u_view_projection * u_objects[ObjectId].model_transform * vec4(vPos, 1.0); //gl_Position is a built-in property of a vertex shader
 }
\ No newline at end of file
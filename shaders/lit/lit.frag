@@ -1,45 +1,129 @@
 //default lit fragment shader
 
-#version 330 core
+#version 460 core
 
+//specialization, injected by Shader::Library for the variants of this program (see Shader::Permutation), the defaults being the general program
+#ifndef LIGHT_COUNT
+#define LIGHT_COUNT 4
+#endif
+
+//SPOT_LIGHT_MASK: bit i is set if light i is a spotlight, read from the light itself when it isn't defined
+
+#ifndef SHADOWS
+#define SHADOWS 1
+#endif
+
+#ifndef TEXTURE
+#define TEXTURE 1
+#endif
+
+//std140 layout, matches Light::ShaderData
 struct Light {
     vec3 position;
-    vec3 color;
-
     float point_spot_influence;
+
+    vec3 color;
     float shadows_influence;
-    vec3 attenuation;
 
+    vec3 attenuation;
     float ambient_strength;
-    float specular_strength;
 
     vec3 spot_dir;
     float spot_cutoff;
 
+    float specular_strength;
+
     mat4 light_view_projection;
 };
 
-uniform vec3 u_cam_pos; //cam position
+//shared by all programs, uploaded once per frame (only when a light changes)
+layout (std140) uniform LightsBlock {
+    Light u_lights[4];
+};
+
+//shared by all programs, written once per pass
+layout (std140) uniform ViewBlock {
+    mat4 u_view; //view matrix
+    mat4 u_projection; //projection matrix
+    mat4 u_view_projection; //view projection matrix
+    vec3 u_cam_pos; //cam position
+};
 
-uniform Light u_lights[4];
 uniform sampler2DArray u_depth_texture;
 
-uniform vec3 u_color; //color
-uniform float u_alpha; //opacity
-uniform int u_shininess; //material shininess
+//std430 layout, matches RenderQueue::ObjectData
+struct Object {
+    mat4 model_transform; //model matrix
+    vec3 color; //color
+    float alpha; //opacity
+    vec2 texture_tiling; //texture (uv) tiling
+    float texture_influence; //are textures enabled?
+    int shininess; //material shininess
+    bool instanced; //is the model matrix combined with a per-instance matrix?
+    bool use_color_palette; //is the color picked in the palette by the material id instead?
+    int texture_layer; //layer of the texture in its array, -1 if it isn't loaded
+    float texture_max_lod; //last mip level of the texture in its layer
+    vec2 texture_scale; //part of the layer covered by the texture
+    vec3 color_palette[8]; //colors of the baked meshes' pieces, matches Shader::MAX_COLOR_PALETTE_SIZE
+};
+
+//per draw, streamed once per frame, indexed by the draw's position in its multi-draw (gl_DrawID)
+layout (std430) readonly buffer ObjectBlock {
+    Object u_objects[];
+};
 
-uniform float u_texture_influence = 0.5; //are textures enabled?
+flat in int ObjectId; //index of the draw in the storage block
 
-uniform sampler2D u_texture; //object texture
+uniform sampler2DArray u_texture; //every texture of the same format as the object's, one per layer
 
 in vec3 FragPos;
 in vec3 Normal;
-in vec4 FragPosLightSpace[4];
+#if SHADOWS && LIGHT_COUNT > 0
+in vec4 FragPosLightSpace[LIGHT_COUNT];
+#endif
 in vec2 FragUv;
+flat in int MaterialId;
 
 layout(location = 0) out vec4 out_color; //rgba color output
 
-vec3 calculateSpotLight(Light light, vec4 fragPosLightSpace, int index) {
+//samples the object's texture in its layer of the array (see Texture::Array), white until it's loaded
+//the sampler clamps, since the edges of the layer aren't the texture's, so the uvs are wrapped here
+vec4 sampleTexture(vec2 uv) {
+    if (u_objects[ObjectId].texture_layer < 0)
+        return vec4(1.0);
+
+    vec2 scale = u_objects[ObjectId].texture_scale;
+
+    //the level is picked from the unwrapped uvs, so that it doesn't jump at the seams, and stops at the texture's last one
+    float lod = min(textureQueryLod(u_texture, uv * scale).y, u_objects[ObjectId].texture_max_lod);
+
+    //half a texel of the coarser level away from the texture's edges, so that filtering doesn't read the rest of the layer
+    vec2 halfTexel = 0.5 * exp2(ceil(lod)) / vec2(textureSize(u_texture, 0).xy);
+    vec2 layerUv = clamp(fract(uv) * scale, halfTexel, scale - halfTexel);
+
+    return textureLod(u_texture, vec3(layerUv, u_objects[ObjectId].texture_layer), lod);
+}
+
+float calculateShadow(Light light, vec3 norm, vec3 lightDir, int index) {
+#if SHADOWS && LIGHT_COUNT > 0
+    vec4 fragPosLightSpace = FragPosLightSpace[index];
+
+    vec3 projectedCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
+    projectedCoords = projectedCoords * 0.5 + 0.5;
+
+    // get closest depth value from light's perspective (using [0,1] range LightSpaceFragPos as coords)
+    float closestDepth = texture(u_depth_texture, vec3(projectedCoords.xy, index)).r;
+
+    // get current linear depth as stored in the depth buffer
+    float currentDepth = projectedCoords.z;
+
+    return (currentDepth - max(0.000100 * (1.0 - dot(norm, lightDir)), 0.000025)) < closestDepth ? 1.0 : light.shadows_influence; //bias calculation comes from: https://learnopengl.com/Advanced-Lighting/Shadows/Shadow-Mapping
+#else
+    return 1.0; //shadows off, no lookup at all
+#endif
+}
+
+vec3 calculateSpotLight(Light light, int index) {
     //diffuse lighting calculation
     vec3 norm = normalize(Normal);
     vec3 lightDir = normalize(light.position - FragPos);
@@ -55,20 +139,11 @@ vec3 calculateSpotLight(Light light, vec4 fragPosLightSpace, int index) {
     vec3 viewDir = normalize(u_cam_pos - FragPos);
     vec3 reflectDir = normalize(reflect(-lightDir, norm));
 
-    float specularFactor = pow(max(dot(viewDir, reflectDir), 0.0), u_shininess);
+    float specularFactor = pow(max(dot(viewDir, reflectDir), 0.0), u_objects[ObjectId].shininess);
     vec3 specular = specularFactor * light.specular_strength * light.color;
 
     //shadow calculation
-    vec3 projectedCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
-    projectedCoords = projectedCoords * 0.5 + 0.5;
-
-    // get closest depth value from light's perspective (using [0,1] range LightSpaceFragPos as coords)
-    float closestDepth = texture(u_depth_texture, vec3(projectedCoords.xy, index)).r;
-
-    // get current linear depth as stored in the depth buffer
-    float currentDepth = projectedCoords.z;
-
-    float shadowScalar = (currentDepth - max(0.000100 * (1.0 - dot(norm, lightDir)), 0.000025)) < closestDepth ? 1.0 : light.shadows_influence; //bias calculation comes from: https://learnopengl.com/Advanced-Lighting/Shadows/Shadow-Mapping
+    float shadowScalar = calculateShadow(light, norm, lightDir, index);
 
     vec3 colorResult = (diffuse + specular) * max(theta - light.spot_cutoff, 0.0) * //spotlight
                             shadowScalar * //shadows
@@ -77,7 +152,7 @@ vec3 calculateSpotLight(Light light, vec4 fragPosLightSpace, int index) {
     return colorResult;
 }
 
-vec3 calculatePointLight(Light light, vec4 fragPosLightSpace, int index) {
+vec3 calculatePointLight(Light light, int index) {
     //diffuse lighting calculation
     vec3 norm = normalize(Normal);
     vec3 lightDir = normalize(light.position - FragPos);
@@ -90,20 +165,11 @@ vec3 calculatePointLight(Light light, vec4 fragPosLightSpace, int index) {
     vec3 viewDir = normalize(u_cam_pos - FragPos);
     vec3 reflectDir = normalize(reflect(-lightDir, norm));
 
-    float specularFactor = pow(max(dot(viewDir, reflectDir), 0.0), u_shininess);
+    float specularFactor = pow(max(dot(viewDir, reflectDir), 0.0), u_objects[ObjectId].shininess);
     vec3 specular = specularFactor * light.specular_strength * light.color;
 
     //shadow calculation
-    vec3 projectedCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
-    projectedCoords = projectedCoords * 0.5 + 0.5;
-
-    // get closest depth value from light's perspective (using [0,1] range LightSpaceFragPos as coords)
-    float closestDepth = texture(u_depth_texture, vec3(projectedCoords.xy, index)).r;
-
-    // get current linear depth as stored in the depth buffer
-    float currentDepth = projectedCoords.z;
-
-    float shadowScalar = (currentDepth - max(0.000100 * (1.0 - dot(norm, lightDir)), 0.000025)) < closestDepth ? 1.0 : light.shadows_influence; //bias calculation comes from: https://learnopengl.com/Advanced-Lighting/Shadows/Shadow-Mapping
+    float shadowScalar = calculateShadow(light, norm, lightDir, index);
 
     vec3 colorResult = (diffuse + specular) * //spotlight
     shadowScalar * //shadows
@@ -114,21 +180,38 @@ vec3 calculatePointLight(Light light, vec4 fragPosLightSpace, int index) {
 
 //entrypoint
 void main() {
-    vec3 approximateAmbient;
-    vec3 lightsColor;
+    vec3 approximateAmbient = vec3(0.0);
+    vec3 lightsColor = vec3(0.0);
 
     for (int i = 0; i < u_lights.length(); i++) {
         approximateAmbient += (u_lights[i].ambient_strength * u_lights[i].color);
-
-        if (u_lights[i].point_spot_influence < 0.5) //point light
-            lightsColor += calculatePointLight(u_lights[i], FragPosLightSpace[i], i);
-        else //spotlight
-            lightsColor += calculateSpotLight(u_lights[i], FragPosLightSpace[i], i);
     }
 
     approximateAmbient = approximateAmbient / u_lights.length();
 
-    vec3 colorResult = (approximateAmbient + lightsColor) * vec3(mix(vec4(u_color, 1.0), texture(u_texture, FragUv), u_texture_influence)); //pure color or texture, mixed with lighting
+    //a constant count, so the loop can be unrolled
+    for (int i = 0; i < LIGHT_COUNT; i++) {
+#ifdef SPOT_LIGHT_MASK
+        bool spotlight = ((SPOT_LIGHT_MASK >> i) & 1) != 0; //known at compile time, no branch left once unrolled
+#else
+        bool spotlight = u_lights[i].point_spot_influence >= 0.5;
+#endif
+
+        if (spotlight)
+            lightsColor += calculateSpotLight(u_lights[i], i);
+        else //point light
+            lightsColor += calculatePointLight(u_lights[i], i);
+    }
+
+    vec3 color = u_objects[ObjectId].use_color_palette ? u_objects[ObjectId].color_palette[MaterialId] : u_objects[ObjectId].color; //baked meshes pick their pieces' colors in the palette
+
+#if TEXTURE
+    vec4 textureColor = sampleTexture(FragUv);
+#else
+    vec4 textureColor = vec4(1.0); //untextured material, like the placeholder
+#endif
+
+    vec3 colorResult = (approximateAmbient + lightsColor) * vec3(mix(vec4(color, 1.0), textureColor, u_objects[ObjectId].texture_influence)); //pure color or texture, mixed with lighting
 
-    out_color = vec4(colorResult, u_alpha);
+    out_color = vec4(colorResult, u_objects[ObjectId].alpha);
 }
\ No newline at end of file
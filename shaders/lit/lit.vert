@@ -1,50 +1,102 @@
 //default lit vertex shader
 
-#version 330 core
+#version 460 core
 
+//specialization, injected by Shader::Library for the variants of this program (see Shader::Permutation), the defaults being the general program
+#ifndef LIGHT_COUNT
+#define LIGHT_COUNT 4
+#endif
+
+#ifndef SHADOWS
+#define SHADOWS 1
+#endif
+
+//std140 layout, matches Light::ShaderData
 struct Light {
     vec3 position;
-    vec3 color;
-
     float point_spot_influence;
+
+    vec3 color;
     float shadows_influence;
-    vec3 attenuation;
 
+    vec3 attenuation;
     float ambient_strength;
-    float specular_strength;
 
     vec3 spot_dir;
     float spot_cutoff;
 
+    float specular_strength;
+
     mat4 light_view_projection;
 };
 
-uniform Light u_lights[4];
+//shared by all programs, uploaded once per frame (only when a light changes)
+layout (std140) uniform LightsBlock {
+    Light u_lights[4];
+};
 
-uniform mat4 u_model_transform; //model matrix
-uniform mat4 u_view_projection; //view projection matrix
+//std430 layout, matches RenderQueue::ObjectData
+struct Object {
+    mat4 model_transform; //model matrix
+    vec3 color; //color
+    float alpha; //opacity
+    vec2 texture_tiling; //texture (uv) tiling
+    float texture_influence; //are textures enabled?
+    int shininess; //material shininess
+    bool instanced; //is the model matrix combined with a per-instance matrix?
+    bool use_color_palette; //is the color picked in the palette by the material id instead?
+    int texture_layer; //layer of the texture in its array, -1 if it isn't loaded
+    float texture_max_lod; //last mip level of the texture in its layer
+    vec2 texture_scale; //part of the layer covered by the texture
+    vec3 color_palette[8]; //colors of the baked meshes' pieces, matches Shader::MAX_COLOR_PALETTE_SIZE
+};
 
-uniform vec2 u_texture_tiling; //texture (uv) tiling
+//per draw, streamed once per frame, indexed by the draw's position in its multi-draw (gl_DrawID)
+layout (std430) readonly buffer ObjectBlock {
+    Object u_objects[];
+};
+
+//shared by all programs, written once per pass
+layout (std140) uniform ViewBlock {
+    mat4 u_view; //view matrix
+    mat4 u_projection; //projection matrix
+    mat4 u_view_projection; //view projection matrix
+    vec3 u_cam_pos; //cam position
+};
 
 layout (location = 0) in vec3 vPos; //vertex input position
 layout (location = 1) in vec3 vNormal; //vertex input normal
 layout (location = 2) in vec2 vUv; //vertex input uv
+layout (location = 3) in mat4 vInstanceTransform; //per-instance model matrix (only used when instanced)
+layout (location = 7) in float vMaterialId; //index in the color palette (only used by baked meshes)
 
 out vec3 Normal;
 out vec3 FragPos;
-out vec4 FragPosLightSpace[4];
+#if SHADOWS && LIGHT_COUNT > 0
+out vec4 FragPosLightSpace[LIGHT_COUNT];
+#endif
 out vec2 FragUv;
+flat out int MaterialId;
+flat out int ObjectId; //index of the draw in the storage block, for the fragment shader
 
 void main() {
-    Normal = mat3(transpose(inverse(u_model_transform))) * vNormal; //we need to transform the normal with the normal matrix (https://learnopengl.com/Lighting/Basic-Lighting & http://www.lighthouse3d.com/tutorials/glsl-12-tutorial/the-normal-matrix/)
+    ObjectId = gl_DrawID; //position of the draw in its multi-draw (0 for regular draws)
+
+    mat4 model_transform = u_objects[ObjectId].instanced ? u_objects[ObjectId].model_transform * vInstanceTransform : u_objects[ObjectId].model_transform;
 
-    FragPos = vec3(u_model_transform * vec4(vPos, 1.0));
+    Normal = mat3(transpose(inverse(model_transform))) * vNormal; //we need to transform the normal with the normal matrix (https://learnopengl.com/Lighting/Basic-Lighting & http://www.lighthouse3d.com/tutorials/glsl-12-tutorial/the-normal-matrix/)
 
-    for (int i = 0; i < u_lights.length(); i++) {
+    FragPos = vec3(model_transform * vec4(vPos, 1.0));
+
+#if SHADOWS && LIGHT_COUNT > 0
+    for (int i = 0; i < LIGHT_COUNT; i++) {
         FragPosLightSpace[i] = u_lights[i].light_view_projection * vec4(FragPos, 1.0);
     }
+#endif
+
+    FragUv = vUv / u_objects[ObjectId].texture_tiling;
 
-    FragUv = vUv / u_texture_tiling;
+    MaterialId = int(vMaterialId + 0.5);
 
-    gl_Position = u_view_projection * u_model_transform * vec4(vPos, 1.0); //gl_Position is a built-in property of a vertex shader
+    gl_Position = u_view_projection * model_transform * vec4(vPos, 1.0); //gl_Position is a built-in property of a vertex shader
 }
\ No newline at end of file
@@ -1,6 +1,6 @@
 //default shadow mapper fragment shader
 
-#version 330 core
+#version 460 core
 
 in vec3 FragPos;
 
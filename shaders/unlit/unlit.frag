@@ -1,19 +1,66 @@
 //default unlit fragment shader
 
-#version 330 core
+#version 460 core
 
-uniform vec3 u_color; //color
-uniform float u_alpha; //opacity
+//specialization, injected by Shader::Library for the variants of this program (see Shader::Permutation), the default being the general program
+#ifndef TEXTURE
+#define TEXTURE 1
+#endif
 
-uniform float u_texture_influence = 0.0; //are textures enabled?
+//std430 layout, matches RenderQueue::ObjectData
+struct Object {
+    mat4 model_transform; //model matrix
+    vec3 color; //color
+    float alpha; //opacity
+    vec2 texture_tiling; //texture (uv) tiling
+    float texture_influence; //are textures enabled?
+    int shininess; //material shininess
+    bool instanced; //is the model matrix combined with a per-instance matrix?
+    bool use_color_palette; //is the color picked in the palette by the material id instead?
+    int texture_layer; //layer of the texture in its array, -1 if it isn't loaded
+    float texture_max_lod; //last mip level of the texture in its layer
+    vec2 texture_scale; //part of the layer covered by the texture
+    vec3 color_palette[8]; //colors of the baked meshes' pieces, matches Shader::MAX_COLOR_PALETTE_SIZE
+};
 
-uniform sampler2D u_texture; //object texture
+//per draw, streamed once per frame, indexed by the draw's position in its multi-draw (gl_DrawID)
+layout (std430) readonly buffer ObjectBlock {
+    Object u_objects[];
+};
+
+flat in int ObjectId; //index of the draw in the storage block
+
+uniform sampler2DArray u_texture; //every texture of the same format as the object's, one per layer
 
 in vec2 FragUv;
 
 layout(location = 0) out vec4 out_color; //rgba color output
 
+//samples the object's texture in its layer of the array (see Texture::Array), white until it's loaded
+//the sampler clamps, since the edges of the layer aren't the texture's, so the uvs are wrapped here
+vec4 sampleTexture(vec2 uv) {
+    if (u_objects[ObjectId].texture_layer < 0)
+        return vec4(1.0);
+
+    vec2 scale = u_objects[ObjectId].texture_scale;
+
+    //the level is picked from the unwrapped uvs, so that it doesn't jump at the seams, and stops at the texture's last one
+    float lod = min(textureQueryLod(u_texture, uv * scale).y, u_objects[ObjectId].texture_max_lod);
+
+    //half a texel of the coarser level away from the texture's edges, so that filtering doesn't read the rest of the layer
+    vec2 halfTexel = 0.5 * exp2(ceil(lod)) / vec2(textureSize(u_texture, 0).xy);
+    vec2 layerUv = clamp(fract(uv) * scale, halfTexel, scale - halfTexel);
+
+    return textureLod(u_texture, vec3(layerUv, u_objects[ObjectId].texture_layer), lod);
+}
+
 //entrypoint
 void main() {
-    out_color = mix(vec4(u_color, u_alpha), texture(u_texture, FragUv), u_texture_influence);
+#if TEXTURE
+    vec4 textureColor = sampleTexture(FragUv);
+#else
+    vec4 textureColor = vec4(1.0); //untextured material, like the placeholder
+#endif
+
+    out_color = mix(vec4(u_objects[ObjectId].color, u_objects[ObjectId].alpha), textureColor, u_objects[ObjectId].texture_influence);
 }
\ No newline at end of file
@@ -64,6 +64,8 @@ public:
     void SetTarget(const glm::vec3& _target);
 
     [[nodiscard]] glm::vec3 GetPosition() const;
+    [[nodiscard]] glm::mat4 GetView() const;
+    [[nodiscard]] glm::mat4 GetProjection() const;
     [[nodiscard]] glm::mat4 GetViewProjection() const;
 
     [[nodiscard]] glm::vec3 GetCamUp() const;
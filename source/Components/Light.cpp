@@ -54,10 +54,34 @@ float Light::GetSpotlightCutoff() const {
     return glm::cos(glm::radians(cutoff));
 }
 
+glm::mat4 Light::GetView() const {
+    return view_matrix;
+}
+
+glm::mat4 Light::GetProjection() const {
+    return projection_matrix;
+}
+
 glm::mat4 Light::GetViewProjection() const {
     return projection_matrix * view_matrix;
 }
 
+Light::ShaderData Light::GetShaderData() const {
+    return {
+        .position = position,
+        .point_spot_influence = type == Type::POINT ? 0.0f : 1.0f,
+        .color = color,
+        .shadows_influence = 1.0f - (float)project_shadows,
+        .attenuation = attenuation,
+        .ambient_strength = ambient_strength,
+        .spot_dir = GetSpotlightDirection(),
+        .spot_cutoff = GetSpotlightCutoff(),
+        .specular_strength = specular_strength,
+        .padding = {},
+        .light_view_projection = GetViewProjection(),
+    };
+}
+
 void Light::UpdateView() {
     light_forward = glm::normalize(position - target);
     light_right = glm::normalize(glm::cross(light_forward, Transforms::UP));
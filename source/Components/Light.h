@@ -16,6 +16,26 @@ public:
         SPOT,
     };
 
+    // std140 layout of one light, exactly as the LightsBlock uniform block of the shaders expects it
+    struct ShaderData {
+        glm::vec3 position;
+        float point_spot_influence;
+
+        glm::vec3 color;
+        float shadows_influence;
+
+        glm::vec3 attenuation;
+        float ambient_strength;
+
+        glm::vec3 spot_dir;
+        float spot_cutoff;
+
+        float specular_strength;
+        float padding[3];
+
+        glm::mat4 light_view_projection;
+    };
+
     Type type = Type::POINT;
     bool project_shadows = true;
 
@@ -26,6 +46,7 @@ public:
     float ambient_strength = 0.1f;
     float specular_strength = 0.5f;
 
+    inline constexpr static int MAX_LIGHTS = 4; //size of the lights array in the shaders
     inline static int LIGHTMAP_SIZE = 2048;
     inline constexpr static float FOV = 80.0f;
     inline constexpr static float NEAR_PLANE = 0.1f;
@@ -57,10 +78,16 @@ public:
     [[nodiscard]] glm::vec3 GetSpotlightDirection() const;
     [[nodiscard]] float GetSpotlightCutoff() const;
 
+    [[nodiscard]] glm::mat4 GetView() const;
+    [[nodiscard]] glm::mat4 GetProjection() const;
     [[nodiscard]] glm::mat4 GetViewProjection() const;
 
+    [[nodiscard]] ShaderData GetShaderData() const;
+
 private:
     void UpdateView(); //for when the camera's rotation changes
     void UpdateProjection(); //for when the camera's viewport changes (mainly)
     void UpdateAttenuation(); //for when the range changes
 };
+
+static_assert(sizeof(Light::ShaderData) == 144, "Light::ShaderData must match the std140 layout of the shaders' Light struct");
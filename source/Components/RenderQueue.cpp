@@ -0,0 +1,385 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+RenderQueue::RenderQueue() {
+    view_buffer = std::make_unique<UniformBuffer>(Shader::VIEW_BLOCK_BINDING, sizeof(ViewData));
+
+    //each batch's ObjectData are bound at their own offset, which is rounded up to the storage buffer offset alignment (worst case: one packet per batch)
+    GLint alignment = 1;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+    const GLsizeiptr aligned_object_size = (sizeof(ObjectData) + alignment - 1) / alignment * alignment;
+    object_buffer = std::make_unique<StreamBuffer>(GL_SHADER_STORAGE_BUFFER, aligned_object_size * MAX_DRAWS_PER_FRAME);
+    command_buffer = std::make_unique<StreamBuffer>(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsCommand) * MAX_DRAWS_PER_FRAME);
+}
+
+int RenderQueue::AddPass(const RenderQueue::Pass &_pass) {
+    passes.push_back(_pass);
+
+    return (int)passes.size() - 1;
+}
+
+void RenderQueue::Submit(int _pass, const VisualObject &_object, const glm::mat4 &_transform, int _renderMode, const Shader::Material *_materialOverride) {
+    Record(_pass, _object, _transform, _renderMode, _materialOverride, 0);
+}
+
+void RenderQueue::SubmitInstanced(int _pass, const VisualObject &_object, const glm::mat4 &_transform, int _renderMode, const Shader::Material *_materialOverride) {
+    // nothing to draw if there are no instances
+    if (_object.GetInstanceCount() == 0)
+        return;
+
+    Record(_pass, _object, _transform, _renderMode, _materialOverride, _object.GetInstanceCount());
+}
+
+void RenderQueue::Record(int _pass, const VisualObject &_object, const glm::mat4 &_transform, int _renderMode, const Shader::Material *_materialOverride, int _instanceCount) {
+    const auto &cull_frusta = passes[_pass].cull_frusta;
+    const Shader::Material *material = _materialOverride != nullptr ? _materialOverride : &_object.material;
+    const Shader *shader = material->shader.get();
+
+    // specialized for the pass' lights & shadows, and for whether the material is textured at all
+    if (passes[_pass].permutation) {
+        Shader::Permutation permutation = *passes[_pass].permutation;
+        permutation.texture = material->texture_influence > 0.0f;
+
+        shader = &material->shader->GetVariant(permutation);
+    }
+
+    // the program is still compiling (see Shader::Library::PollPending)
+    if (!shader->IsReady()) {
+        compiling++;
+        return;
+    }
+
+    // world bounds of the object (which include all of its instances), only needed for culling & levels of detail
+    Bounds world_bounds;
+
+    if (!cull_frusta.empty() || _object.HasLods())
+        world_bounds = _object.GetBounds().Transformed(_transform);
+
+    // culling
+    if (!cull_frusta.empty()) {
+        const bool visible = std::any_of(cull_frusta.begin(), cull_frusta.end(), [&world_bounds](const Frustum &_frustum) {
+            return _frustum.Intersects(world_bounds);
+        });
+
+        if (!visible) {
+            culled++;
+            return;
+        }
+    }
+
+    // instanced objects draw their own mesh, the levels of detail are picked for a single transform
+    const Mesh *mesh = &_object.GetMesh();
+
+    if (_object.HasLods() && _instanceCount == 0)
+        mesh = &_object.GetLodMesh(GetScreenSize(passes[_pass], world_bounds));
+
+    Packet packet = {
+        .object = &_object,
+        .mesh = mesh,
+        .material = material,
+        .shader = shader,
+        .transform = _transform,
+        .pass = _pass,
+        .render_mode = _renderMode,
+        .instance_count = _instanceCount,
+    };
+
+    packet.sort_key = MakeSortKey(packet);
+
+    packets.push_back(packet);
+}
+
+uint64_t RenderQueue::MakeSortKey(const RenderQueue::Packet &_packet) {
+    // key layout, from the most significant bits to the least:
+    // opaque:      pass (8) | 0 (1) | program (16) | texture (16) | vertex array (16) | unused (7)
+    // translucent: pass (8) | 1 (1) | unused (23) | recording order (32)
+    uint64_t key = (uint64_t)(_packet.pass & 0xFF) << 56;
+
+    if (_packet.material->alpha < 1.0f) {
+        // translucent objects are blended, so they're drawn after all opaque objects, in the order they were recorded
+        key |= (uint64_t)1 << 55;
+        key |= (uint64_t)sequence++;
+
+        return key;
+    }
+
+    key |= (uint64_t)(_packet.shader->program_id & 0xFFFF) << 39;
+    key |= (uint64_t)(_packet.material->texture->GetId() & 0xFFFF) << 23;
+    key |= (uint64_t)(_packet.mesh->GetVertexArray() & 0xFFFF) << 7;
+
+    return key;
+}
+
+float RenderQueue::GetScreenSize(const RenderQueue::Pass &_pass, const Bounds &_worldBounds) {
+    float screen_size = 0.0f;
+
+    const auto measure = [&_worldBounds, &screen_size](const glm::mat4 &_viewProjection) {
+        //w is the view depth for a perspective projection and 1 for an orthographic one, and the length of the clip y row scales world units to the view's half-height (so it's halved for the whole height)
+        const float w = (_viewProjection * glm::vec4(_worldBounds.center, 1.0f)).w;
+        const float y_scale = glm::length(glm::vec3(_viewProjection[0][1], _viewProjection[1][1], _viewProjection[2][1]));
+
+        //the eye is inside the bounds (or really close to them), the finest level is needed
+        if (w <= _worldBounds.radius) {
+            screen_size = std::numeric_limits<float>::max();
+            return;
+        }
+
+        screen_size = std::max(screen_size, _worldBounds.radius * y_scale * 0.5f / w);
+    };
+
+    if (_pass.lod_view_projections.empty())
+        measure(_pass.projection * _pass.view);
+
+    for (const auto &view_projection: _pass.lod_view_projections)
+        measure(view_projection);
+
+    return screen_size;
+}
+
+void RenderQueue::Flush() {
+    // stable, so that packets with the same state keep their recording order
+    std::stable_sort(packets.begin(), packets.end(), [](const Packet &_a, const Packet &_b) {
+        return _a.sort_key < _b.sort_key;
+    });
+
+    stats = Stats();
+    stats.culled = culled;
+    stats.compiling = compiling;
+
+    // consecutive packets sharing all of their state are drawn together
+    batches.clear();
+
+    for (size_t i = 0; i < packets.size(); ++i) {
+        //a batch never holds more than a stream buffer region, so that it always fits in an empty one
+        if (batches.empty() || !CanShareBatch(packets[i - 1], packets[i]) || batches.back().packet_count == MAX_DRAWS_PER_FRAME)
+            batches.push_back({ .first_packet = i });
+
+        batches.back().packet_count++;
+    }
+
+    // per-draw data & commands, copied into the mapped stream buffers without any driver call as each batch is drawn
+    object_buffer->BeginFrame();
+    command_buffer->BeginFrame();
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer->GetId());
+
+    int current_pass = -1;
+    GLuint current_program = 0;
+    GLuint current_texture = 0;
+    GLuint current_vertex_array = 0;
+    float current_line_thickness = -1.0f;
+    float current_point_size = -1.0f;
+
+    // programs whose sampler uniforms are already set for the current pass
+    std::vector<GLuint> programs_with_samplers;
+
+    for (auto &batch: batches) {
+        StreamBatch(batch);
+
+        // more draws than the stream buffers' region can hold: the draws already submitted are fenced, and the rest of the frame goes on in the next region
+        // (only waits if the GPU is still reading that region, from an earlier frame or from earlier in this one)
+        if (batch.objects_offset < 0) {
+            object_buffer->EndFrame();
+            command_buffer->EndFrame();
+            object_buffer->BeginFrame();
+            command_buffer->BeginFrame();
+
+            StreamBatch(batch);
+            stats.stream_wraps++;
+        }
+
+        // still doesn't fit, i.e. the stream buffers couldn't be mapped
+        if (batch.objects_offset < 0) {
+            stats.dropped += batch.packet_count;
+            continue;
+        }
+
+        // all packets of the batch share the same state
+        const auto &packet = packets[batch.first_packet];
+        const auto &material = *packet.material;
+        const auto &shader = *packet.shader;
+
+        // render target & view
+        if (packet.pass != current_pass) {
+            current_pass = packet.pass;
+
+            const auto &pass = passes[current_pass];
+
+            if (pass.setup)
+                pass.setup();
+
+            // every program reads the view from the same uniform block, so it's only written once per pass
+            const ViewData view_data = {
+                .view = pass.view,
+                .projection = pass.projection,
+                .view_projection = pass.projection * pass.view,
+                .eye_position = pass.eye_position,
+            };
+
+            view_buffer->UploadAlways(&view_data, sizeof(view_data));
+
+            programs_with_samplers.clear();
+        }
+
+        // shader program
+        if (shader.program_id != current_program || stats.draw_calls == 0) {
+            current_program = shader.program_id;
+            shader.Use();
+
+            stats.program_switches++;
+        }
+
+        // samplers shared by every draw of this pass, only set once per program (the view & lights are in their own uniform buffers)
+        if (std::find(programs_with_samplers.begin(), programs_with_samplers.end(), shader.program_id) == programs_with_samplers.end()) {
+            shader.SetTexture("u_depth_texture", 0);
+            shader.SetTexture("u_texture", 1);
+
+            programs_with_samplers.push_back(shader.program_id);
+        }
+
+        // texture
+        if (material.texture->GetId() != current_texture || stats.draw_calls == 0) {
+            current_texture = material.texture->GetId();
+            material.texture->Use(GL_TEXTURE1);
+
+            stats.texture_switches++;
+        }
+
+        // vertex array
+        if (packet.mesh->GetVertexArray() != current_vertex_array || stats.draw_calls == 0) {
+            current_vertex_array = packet.mesh->GetVertexArray();
+            glBindVertexArray(current_vertex_array);
+
+            stats.vertex_array_switches++;
+        }
+
+        // per-draw properties, already streamed (gl_DrawID indexes them from the batch's first packet)
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, Shader::OBJECT_BLOCK_BINDING, object_buffer->GetId(), batch.objects_offset, (GLsizeiptr)(batch.packet_count * sizeof(ObjectData)));
+
+        // line & point properties
+        if (material.line_thickness != current_line_thickness) {
+            current_line_thickness = material.line_thickness;
+            glLineWidth(current_line_thickness);
+        }
+
+        if (material.point_size != current_point_size) {
+            current_point_size = material.point_size;
+            glPointSize(current_point_size);
+        }
+
+        // instanced objects attach their own instance data, so they're always drawn alone & directly
+        if (packet.instance_count > 0)
+            packet.object->DrawGeometry(packet.render_mode, packet.instance_count);
+        else if (packet.mesh->IsIndexed())
+            glMultiDrawElementsIndirect(packet.render_mode, GL_UNSIGNED_INT, (const GLvoid *)batch.commands_offset, batch.packet_count, 0);
+        else
+            glMultiDrawArraysIndirect(packet.render_mode, (const GLvoid *)batch.commands_offset, batch.packet_count, 0);
+
+        stats.draw_calls++;
+        stats.packets += batch.packet_count;
+    }
+
+    // the stream buffers' regions can only be rewritten once the GPU is done with these draws
+    object_buffer->EndFrame();
+    command_buffer->EndFrame();
+
+    if (stats.dropped > 0)
+        std::cerr << "Error::RenderQueue -> " << stats.dropped << " draws were dropped this frame, the stream buffers are unusable" << std::endl;
+
+    // cleanup
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+    Texture::Clear();
+
+    packets.clear();
+    passes.clear();
+    sequence = 0;
+    culled = 0;
+    compiling = 0;
+}
+
+bool RenderQueue::CanShareBatch(const RenderQueue::Packet &_a, const RenderQueue::Packet &_b) {
+    // instanced objects bind their own instance buffer, which other draws can't read
+    if (_a.instance_count > 0 || _b.instance_count > 0)
+        return false;
+
+    const auto &material_a = *_a.material;
+    const auto &material_b = *_b.material;
+
+    return _a.pass == _b.pass && _a.render_mode == _b.render_mode &&
+           _a.shader->program_id == _b.shader->program_id && material_a.texture->GetId() == material_b.texture->GetId() &&
+           material_a.line_thickness == material_b.line_thickness && material_a.point_size == material_b.point_size &&
+           _a.mesh->GetVertexArray() == _b.mesh->GetVertexArray() && _a.mesh->IsIndexed() == _b.mesh->IsIndexed();
+}
+
+void RenderQueue::StreamBatch(RenderQueue::Batch &_batch) {
+    // every object is overwritten below, so the scratch vectors only grow when a batch is bigger than any before it
+    batch_objects.resize(_batch.packet_count);
+    batch_elements_commands.clear();
+    batch_arrays_commands.clear();
+
+    for (int i = 0; i < _batch.packet_count; ++i) {
+        const auto &packet = packets[_batch.first_packet + i];
+        const auto &material = *packet.material;
+
+        batch_objects[i] = {
+            .model_transform = packet.transform,
+            .color = material.color,
+            .alpha = material.alpha,
+            .texture_tiling = material.texture_tiling,
+            .texture_influence = material.texture_influence,
+            .shininess = material.shininess,
+            .instanced = packet.instance_count > 0,
+            .use_color_palette = !material.color_palette.empty(),
+            .texture_layer = material.texture->GetLayer(),
+            .texture_max_lod = material.texture->GetMaxLod(),
+            .texture_scale = material.texture->GetUvScale(),
+        };
+
+        for (int j = 0; j < material.color_palette.size() && j < Shader::MAX_COLOR_PALETTE_SIZE; ++j)
+            batch_objects[i].color_palette[j] = glm::vec4(material.color_palette[j], 0.0f);
+
+        // where the object's geometry (or its level of detail) lives in the mesh arena
+        const Mesh &mesh = *packet.mesh;
+
+        if (mesh.IsIndexed()) {
+            batch_elements_commands.push_back({
+                .count = (GLuint)mesh.GetIndexRange().count,
+                .instance_count = 1,
+                .first_index = (GLuint)mesh.GetIndexRange().offset,
+                .base_vertex = mesh.GetVertexRange().offset,
+                .base_instance = 0,
+            });
+        } else {
+            batch_arrays_commands.push_back({
+                .count = (GLuint)mesh.GetVertexRange().count,
+                .instance_count = 1,
+                .first = (GLuint)mesh.GetVertexRange().offset,
+                .base_instance = 0,
+            });
+        }
+    }
+
+    _batch.objects_offset = object_buffer->Write(batch_objects.data(), (GLsizeiptr)(batch_objects.size() * sizeof(ObjectData)));
+
+    // instanced batches are drawn directly, without commands
+    if (packets[_batch.first_packet].instance_count > 0)
+        return;
+
+    if (!batch_elements_commands.empty())
+        _batch.commands_offset = command_buffer->Write(batch_elements_commands.data(), (GLsizeiptr)(batch_elements_commands.size() * sizeof(DrawElementsCommand)));
+    else
+        _batch.commands_offset = command_buffer->Write(batch_arrays_commands.data(), (GLsizeiptr)(batch_arrays_commands.size() * sizeof(DrawArraysCommand)));
+
+    // a batch is only drawn if both its objects & its commands fit
+    if (_batch.commands_offset < 0)
+        _batch.objects_offset = -1;
+}
+
+const RenderQueue::Stats &RenderQueue::GetStats() const {
+    return stats;
+}
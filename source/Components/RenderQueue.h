@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "glad/glad.h"
+#include "glm/vec3.hpp"
+#include "glm/mat4x4.hpp"
+#include "Shader.h"
+#include "StreamBuffer.h"
+#include "UniformBuffer.h"
+#include "Utility/Frustum.hpp"
+#include "Visual/VisualObject.h"
+
+// Records the draws of a whole frame as packets, then sorts them (by pass, shader program, texture & vertex array)
+// and submits them with the fewest possible state changes: consecutive packets sharing all of their state are drawn with a single multi-draw indirect
+class RenderQueue {
+public:
+    // A view of the scene (e.g. a light or the main camera) and the render target it draws into
+    struct Pass {
+        glm::mat4 view = glm::mat4(1.0f);
+        glm::mat4 projection = glm::mat4(1.0f);
+        glm::vec3 eye_position = glm::vec3(0.0f);
+
+        std::vector<Frustum> cull_frusta; // submissions outside of all these frusta are culled (none are if it's empty)
+        std::vector<glm::mat4> lod_view_projections; // views the levels of detail are picked for, the finest level any of them needs wins (the pass' own view if it's empty)
+
+        // the programs' variants the pass draws with (see Shader::GetVariant), whether each material is textured is filled in per draw
+        // none draws every program as it is
+        std::optional<Shader::Permutation> permutation;
+
+        std::function<void()> setup; // binds, sizes & clears the render target of this pass
+    };
+
+    // Content of the "ViewBlock" uniform block, laid out following the std140 rules
+    struct ViewData {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::mat4 view_projection;
+        glm::vec3 eye_position; float padding;
+    };
+    static_assert(sizeof(ViewData) == 208, "ViewData must match the std140 layout of the ViewBlock uniform block");
+
+    // Element of the "ObjectBlock" storage block (transform & material of a single draw), laid out following the std430 rules
+    // shaders read the one of their draw with gl_DrawID, its index in the multi-draw
+    struct ObjectData {
+        glm::mat4 model_transform;
+        glm::vec3 color; float alpha;
+        glm::vec2 texture_tiling; float texture_influence; int shininess;
+        int instanced; int use_color_palette; // bools are 4 bytes long in buffer blocks
+        int texture_layer; float texture_max_lod; // where the texture is in its array (see Texture::Array), -1 if it isn't loaded
+        glm::vec2 texture_scale; float padding[2];
+        glm::vec4 color_palette[Shader::MAX_COLOR_PALETTE_SIZE]; // vec3 array elements are padded to 16 bytes, even in std430
+    };
+    static_assert(sizeof(ObjectData) == 256, "ObjectData must match the std430 layout of the shaders' Object struct");
+
+    // Indirect draw arguments, laid out as the GL expects them in the draw indirect buffer
+    struct DrawElementsCommand {
+        GLuint count;
+        GLuint instance_count;
+        GLuint first_index;
+        GLint base_vertex;
+        GLuint base_instance;
+    };
+
+    struct DrawArraysCommand {
+        GLuint count;
+        GLuint instance_count;
+        GLuint first;
+        GLuint base_instance;
+    };
+
+    // Everything needed to draw one object, independently of the order it was recorded in
+    struct Packet {
+        uint64_t sort_key = 0;
+
+        const VisualObject *object = nullptr;
+        const Mesh *mesh = nullptr; // the object's mesh or one of its levels of detail
+        const Shader::Material *material = nullptr;
+        const Shader *shader = nullptr; // the material's program, or its variant for the pass
+        glm::mat4 transform = glm::mat4(1.0f);
+
+        int pass = 0;
+        int render_mode = GL_TRIANGLES;
+        int instance_count = 0; // 0 means a regular (non-instanced) draw
+    };
+
+    // Consecutive packets sharing all of their state, submitted with a single draw call
+    struct Batch {
+        size_t first_packet = 0;
+        int packet_count = 0;
+
+        GLintptr objects_offset = -1; // where the packets' ObjectData were streamed this frame (-1 if they didn't fit)
+        GLintptr commands_offset = -1; // where the packets' indirect commands were streamed this frame
+    };
+
+    // State changes of the last flushed frame
+    struct Stats {
+        int draw_calls = 0;
+        int program_switches = 0;
+        int texture_switches = 0;
+        int vertex_array_switches = 0;
+        int packets = 0; // drawn packets, a multi-draw draws many of them with a single draw call
+        int culled = 0; // submissions that were outside their pass' frusta
+        int compiling = 0; // submissions skipped because their program wasn't ready yet
+        int stream_wraps = 0; // times the frame outgrew a stream buffer region and went on in the next one
+        int dropped = 0; // draws skipped because they couldn't be streamed at all
+    };
+
+private:
+    std::vector<Pass> passes;
+    std::vector<Packet> packets;
+
+    uint32_t sequence = 0; // recording order, used to keep translucent packets in the order they were submitted
+    int culled = 0; // submissions culled since the last flush
+    int compiling = 0; // submissions skipped since the last flush, their program still compiling
+
+    Stats stats;
+
+    // view of the pass being drawn, written once per pass and read by every program
+    std::unique_ptr<UniformBuffer> view_buffer;
+
+    // transform & material of every packet, and indirect commands of every batch, streamed once per frame
+    std::unique_ptr<StreamBuffer> object_buffer;
+    std::unique_ptr<StreamBuffer> command_buffer;
+    inline constexpr static int MAX_DRAWS_PER_FRAME = 4096; // per stream buffer region, a frame with more draws goes on in the next region
+
+    std::vector<Batch> batches;
+
+    // what the batch being streamed writes, kept between batches & frames so that their storage is reused
+    std::vector<ObjectData> batch_objects;
+    std::vector<DrawElementsCommand> batch_elements_commands;
+    std::vector<DrawArraysCommand> batch_arrays_commands;
+
+public:
+    RenderQueue();
+
+    int AddPass(const Pass &_pass); // returns the index of the new pass, to submit packets to it
+
+    void Submit(int _pass, const VisualObject &_object, const glm::mat4 &_transform, int _renderMode = GL_TRIANGLES, const Shader::Material *_materialOverride = nullptr);
+    void SubmitInstanced(int _pass, const VisualObject &_object, const glm::mat4 &_transform, int _renderMode = GL_TRIANGLES, const Shader::Material *_materialOverride = nullptr);
+
+    void Flush(); // sorts & draws all recorded packets, then clears the queue
+
+    [[nodiscard]] const Stats &GetStats() const;
+
+private:
+    void Record(int _pass, const VisualObject &_object, const glm::mat4 &_transform, int _renderMode, const Shader::Material *_materialOverride, int _instanceCount);
+
+    [[nodiscard]] uint64_t MakeSortKey(const Packet &_packet);
+
+    // radius of the bounds as a fraction of the pass' view height, the largest one among its level of detail views
+    [[nodiscard]] static float GetScreenSize(const Pass &_pass, const Bounds &_worldBounds);
+
+    // true if both packets can be part of the same multi-draw
+    [[nodiscard]] static bool CanShareBatch(const Packet &_a, const Packet &_b);
+    void StreamBatch(Batch &_batch); // writes the batch's ObjectData & commands to the stream buffers
+};
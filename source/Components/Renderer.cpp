@@ -1,6 +1,9 @@
 #include "Renderer.h"
+
+#include <algorithm>
 #include "Utility/Input.hpp"
 #include "Utility/Transform.hpp"
+#include "Utility/Frustum.hpp"
 
 Renderer::Renderer(int _initialWidth, int _initialHeight)
 {
@@ -16,10 +19,11 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
     lights->emplace_back(glm::vec3(0.0f, 34.0f, 36.0f), glm::vec3(0.09f, 0.05f, 0.78f), 0.2f, 0.4f, 400.0f, 40.0f, Light::Type::SPOT);
 
     auto grid_shader = Shader::Library::CreateShader("shaders/grid/grid.vert", "shaders/grid/grid.frag");
-    auto unlit_shader = Shader::Library::CreateShader("shaders/unlit/unlit.vert", "shaders/unlit/unlit.frag");
-    auto lit_shader = Shader::Library::CreateShader("shaders/lit/lit.vert", "shaders/lit/lit.frag");
+    // the lit & unlit programs are specialized per pass & material, their variants being compiled when they're first drawn
+    auto unlit_shader = Shader::Library::CreateShader("shaders/unlit/unlit.vert", "shaders/unlit/unlit.frag", Shader::Permutation::TEXTURE);
+    auto lit_shader = Shader::Library::CreateShader("shaders/lit/lit.vert", "shaders/lit/lit.frag", Shader::Permutation::LIGHTS | Shader::Permutation::SHADOWS | Shader::Permutation::TEXTURE);
 
-    auto shadow_mapper_shader = Shader::Library::CreateShader("shaders/shadows/shadow_mapper.vert", "shaders/shadows/shadow_mapper.frag");
+    auto shadow_mapper_shader = Shader::Library::CreateShader("shaders/shadows/shadow_mapper.vert", "shaders/shadows/shadow_mapper.geom", "shaders/shadows/shadow_mapper.frag");
     auto screen_shader = Shader::Library::CreateShader("shaders/screen/screen.vert", "shaders/screen/screen.frag");
 
     shadow_mapper_material = std::make_unique<Shader::Material>();
@@ -28,7 +32,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
     Shader::Material main_light_cube_material = {
         .shader = unlit_shader,
         .color = lights->at(0).GetColor(),
-        .lights = lights,
     };
     main_light_cube = std::make_unique<VisualCube>(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), glm::vec3(0.0f), main_light_cube_material);
 
@@ -41,7 +44,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
     Shader::Material default_s_material = {
         .shader = lit_shader,
         .color = glm::vec3(1.0f),
-        .lights = lights,
     };
 
     // grid
@@ -87,7 +89,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
 
     Shader::Material world_t_material = {
         .shader = lit_shader,
-        .lights = lights,
         .texture = Texture::Library::CreateTexture("assets/clay_texture.jpg"),
         .texture_influence = 1.0f,
         .shininess = 1,
@@ -97,7 +98,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
 
     Shader::Material world_tennisfuzz_material = {
         .shader = lit_shader,
-        .lights = lights,
         .texture = Texture::Library::CreateTexture("assets/fuzz.jpg"),
         .texture_influence = 1.0f,
         .shininess = 1,
@@ -114,7 +114,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
     Shader::Material netpost_s_material = {
         .shader = lit_shader,
         .color = glm::vec3(0.51f, 0.53f, 0.53f),
-        .lights = lights,
         .texture = Texture::Library::CreateTexture("assets/metal.jpg"),
         .texture_influence = 1.0f,
         .texture_tiling = glm::vec2(1.0f, 1.0f / 8.0f),
@@ -125,7 +124,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
     Shader::Material net_s_material = {
         .shader = lit_shader,
         .color = glm::vec3(0.96f, 0.96f, 0.96f),
-        .lights = lights,
         .shininess = 128,
     };
     net_cubes[1] = VisualCube(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), bottom_y_transform_offset, net_s_material); // net
@@ -133,7 +131,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
     Shader::Material top_net_s_material = {
             .shader = lit_shader,
             .color = glm::vec3(0.96f, 0.96f, 0.96f),
-            .lights = lights,
             .texture = Texture::Library::CreateTexture("assets/fabric.jpg"),
             .texture_influence = 1.0f,
             .texture_tiling = 1.0f / glm::vec2(36.0f, 0.2f),
@@ -141,6 +138,8 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
     };
     net_cubes[2] = VisualCube(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), bottom_y_transform_offset, top_net_s_material); // top net
 
+    SetupNetInstances(7, 36);
+
     // letters
     letter_cubes = std::vector<VisualCube>(4);
 
@@ -148,7 +147,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
         .shader = lit_shader,
         .color = glm::vec3(0.15f, 0.92f, 0.17f),
         .alpha = 0.7f,
-        .lights = lights,
         .shininess = 4,
     };
     letter_cubes[0] = VisualCube(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), bottom_y_transform_offset, a_s_material); // letter a
@@ -165,7 +163,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
         .line_thickness = racket_line_thickness,
         .point_size = racket_point_size,
         .color = glm::vec3(0.58f, 0.38f, 0.24f),
-        .lights = lights,
         .texture = Texture::Library::CreateTexture("assets/tattoo.jpg"),
         .texture_influence = 0.9f,
         .texture_tiling = 1.0f / glm::vec2(1.0f, 5.0f),
@@ -178,7 +175,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
             .line_thickness = racket_line_thickness,
             .point_size = racket_point_size,
             .color = glm::vec3(0.2f),
-            .lights = lights,
             .texture = Texture::Library::CreateTexture("assets/rust.jpg"),
             .texture_influence = 0.7f,
             .shininess = 64,
@@ -190,7 +186,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
             .line_thickness = racket_line_thickness,
             .point_size = racket_point_size,
             .color = glm::vec3(0.1f, 0.2f, 0.9f),
-            .lights = lights,
             .texture = Texture::Library::CreateTexture("assets/rust.jpg"),
             .texture_influence = 0.7f,
             .shininess = 64,
@@ -202,7 +197,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
             .line_thickness = racket_line_thickness,
             .point_size = racket_point_size,
             .color = glm::vec3(0.1f, 0.9f, 0.2f),
-            .lights = lights,
             .texture = Texture::Library::CreateTexture("assets/rust.jpg"),
             .texture_influence = 0.7f,
             .shininess = 64,
@@ -215,7 +209,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
             .point_size = racket_point_size,
             .color = glm::vec3(0.94f),
             .alpha = 0.95f,
-            .lights = lights,
             .shininess = 128,
     };
     augusto_racket_materials.push_back(white_plastic_material); // racket net (white plastic)
@@ -260,9 +253,15 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
 
     main_camera->SetPosition(cameras[selected_player].position);
     main_camera->SetTarget(cameras[selected_player].target);
+
+    // scene hierarchy of the net & the rackets (with their letters)
+    BuildScene();
 }
 
 void Renderer::Init() {
+    // initializes the lights uniform buffer, read by every lit program
+    lights_buffer = std::make_unique<UniformBuffer>(Shader::LIGHTS_BLOCK_BINDING, sizeof(Light::ShaderData) * Light::MAX_LIGHTS);
+
     // initializes the shadow map framebuffer
     glGenFramebuffers(1, &shadow_map_fbo);
     glBindFramebuffer(GL_FRAMEBUFFER, shadow_map_fbo);
@@ -284,9 +283,14 @@ void Renderer::Init() {
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
 
-    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH_COMPONENT32, Light::LIGHTMAP_SIZE, Light::LIGHTMAP_SIZE, (GLint)lights->size());
+    // one layer per slot of the lights uniform block, since the layered shadow mapper always writes to all of them
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH_COMPONENT32, Light::LIGHTMAP_SIZE, Light::LIGHTMAP_SIZE, Light::MAX_LIGHTS);
+
+    // clears every layer to the far plane (i.e. no shadow), since the lit program may sample them before the shadow mapper is ready to render them
+    const float clear_depth = 1.0f;
+    glClearTexImage(shadow_map_texture, 0, GL_DEPTH_COMPONENT, GL_FLOAT, &clear_depth);
 
-    // binds the shadow map depth texture to the framebuffer
+    // binds the whole shadow map depth texture (all its layers) to the framebuffer
     glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadow_map_texture, 0);
 
     // disable color draw & read buffer for this framebuffer
@@ -333,275 +337,424 @@ void Renderer::Render(GLFWwindow *_window, const double _deltaTime)
     lights->at(3).SetPosition(main_camera->GetPosition() + main_camera->GetCamRight() * 2.0f);
     lights->at(3).SetTarget(main_camera->GetPosition() + main_camera->GetCamForward() * -10.0f);
 
-    // SHADOW MAP PASS
+    // updates the world matrices of whatever moved, once for all passes
+    UpdateScene();
 
-    // binds the shadow map framebuffer and the depth texture to draw on it
-    glBindFramebuffer(GL_FRAMEBUFFER, shadow_map_fbo);
-    glViewport(0, 0, Light::LIGHTMAP_SIZE, Light::LIGHTMAP_SIZE);
+    // uploads the lights, only if any of them changed since the last frame
+    UploadLights();
 
-    for (int i = 0; i < lights->size(); ++i) {
-        const auto& light = lights->at(i);
+    // uploads the textures decoded since the last frame, their placeholders are drawn until then
+    Texture::Library::UploadDecoded();
 
-        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadow_map_texture, 0, i);
+    // finishes the programs the driver compiled since the last frame, objects using the others are skipped until then
+    Shader::Library::PollPending();
 
-        // clears the depth canvas to black
-        glClear(GL_DEPTH_BUFFER_BIT);
+    // SHADOW MAP PASS
 
-        if (shadow_mode && light_mode) {
-            // draws the net
-            DrawOneNet(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), light.GetViewProjection(), light.GetPosition(), shadow_mapper_material.get());
+    // only the layers whose light or casters changed are re-rendered, the others keep last frame's shadows
+    const int shadow_layer_mask = UpdateShadowLayers();
 
-            // draws the rackets
-            DrawOneRacket(rackets[0].position, rackets[0].rotation, rackets[0].scale, light.GetViewProjection(), light.GetPosition(), 0, shadow_mapper_material.get());
-            DrawOneRacket(rackets[1].position, rackets[1].rotation + glm::vec3(0.0f, 180.0f, 0.0f), rackets[1].scale, light.GetViewProjection(), light.GetPosition(), 1, shadow_mapper_material.get());
+    if (shadow_layer_mask != 0) {
+        // tells the shadow mapper's geometry shader which layers to draw into
+        shadow_mapper_material->shader->SetInt("u_shadow_layer_mask", shadow_layer_mask);
 
-            ground_plane->Draw(light.GetViewProjection(), light.GetPosition(), GL_TRIANGLES, shadow_mapper_material.get());
+        // casters are only drawn if they're seen by at least one of the re-rendered layers' lights, with the level of detail the closest of them needs
+        std::vector<Frustum> shadow_frusta;
+        std::vector<glm::mat4> shadow_view_projections;
+
+        for (int i = 0; i < lights->size() && i < Light::MAX_LIGHTS; ++i) {
+            if (shadow_layer_mask & (1 << i)) {
+                shadow_frusta.emplace_back(lights->at(i).GetViewProjection());
+                shadow_view_projections.push_back(lights->at(i).GetViewProjection());
+            }
         }
-    }
 
-    // unbind the shadow map texture & framebuffer
-    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        // a single layered pass for all lights, the shadow mapper's geometry shader routes every triangle to each light's layer
+        const int shadow_pass = render_queue.AddPass({
+            .cull_frusta = shadow_frusta,
+            .lod_view_projections = shadow_view_projections,
+            .setup = [this, shadow_layer_mask]() {
+                // binds the shadow map framebuffer, which has all the layers of the depth texture attached
+                glBindFramebuffer(GL_FRAMEBUFFER, shadow_map_fbo);
+                glViewport(0, 0, Light::LIGHTMAP_SIZE, Light::LIGHTMAP_SIZE);
+
+                // clears the depth canvas of the re-rendered layers to black, the cached ones are left untouched
+                const float clear_depth = 1.0f;
+
+                for (int i = 0; i < Light::MAX_LIGHTS; ++i) {
+                    if (shadow_layer_mask & (1 << i))
+                        glClearTexSubImage(shadow_map_texture, 0, 0, 0, i, Light::LIGHTMAP_SIZE, Light::LIGHTMAP_SIZE, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &clear_depth);
+                }
+            },
+        });
+
+        // draws the net
+        DrawOneNet(shadow_pass, shadow_mapper_material.get());
+
+        // draws the rackets
+        DrawOneRacket(shadow_pass, 0, shadow_mapper_material.get());
+        DrawOneRacket(shadow_pass, 1, shadow_mapper_material.get());
+
+        render_queue.Submit(shadow_pass, *ground_plane, ground_plane->GetModelMatrix(), GL_TRIANGLES, shadow_mapper_material.get());
+    }
 
     // COLOR PASS
 
-    // resets the viewport to the window size
-    glViewport(0, 0, viewport_width, viewport_height);
+    // the lit program's variant for the current lights: lights turned off (no range) aren't looped over, and no shadow map is read without shadows
+    Shader::Permutation color_permutation = {
+        .light_count = light_mode ? std::min((int)lights->size(), Light::MAX_LIGHTS) : 0,
+        .shadows = shadow_mode,
+    };
 
-    // activates the shadow map depth texture & binds it to the first texture unit, so that it can be used by the lit shader
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, shadow_map_texture);
+    for (int i = 0; i < color_permutation.light_count; ++i) {
+        if (lights->at(i).type != Light::Type::POINT)
+            color_permutation.spot_light_mask |= 1u << i;
+    }
 
-    // clears the color & depth canvas to black
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    const int color_pass = render_queue.AddPass({
+        .view = main_camera->GetView(),
+        .projection = main_camera->GetProjection(),
+        .eye_position = main_camera->GetPosition(),
+        .cull_frusta = { Frustum(main_camera->GetViewProjection()) },
+        .permutation = color_permutation,
+        .setup = [this]() {
+            // unbinds the shadow map framebuffer & resets the viewport to the window size
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(0, 0, viewport_width, viewport_height);
+
+            // activates the shadow map depth texture & binds it to the first texture unit, so that it can be used by the lit shader
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, shadow_map_texture);
+
+            // clears the color & depth canvas to black
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        },
+    });
 
     // draws the world cube
-    world_cube->Draw(main_camera->GetViewProjection(), main_camera->GetPosition());
+    render_queue.Submit(color_pass, *world_cube, world_cube->GetModelMatrix());
 
     // draws the main light cube
     /*for (const auto& light: *lights) {
         main_light_cube->position = light.GetPosition();
-        main_light_cube->Draw(main_camera->GetViewProjection(), main_camera->GetPosition());
+        render_queue.Submit(color_pass, *main_light_cube, main_light_cube->GetModelMatrix());
     }*/
 
     // draws the main grid
-    main_grid->Draw(main_camera->GetViewProjection(), main_camera->GetPosition());
+    render_queue.Submit(color_pass, *main_grid, main_grid->GetModelMatrix(), GL_LINES);
 
     // draws the coordinate axis
-    main_x_line->Draw(main_camera->GetViewProjection(), main_camera->GetPosition());
-    main_y_line->Draw(main_camera->GetViewProjection(), main_camera->GetPosition());
-    main_z_line->Draw(main_camera->GetViewProjection(), main_camera->GetPosition());
+    render_queue.Submit(color_pass, *main_x_line, main_x_line->GetModelMatrix(), GL_LINES);
+    render_queue.Submit(color_pass, *main_y_line, main_y_line->GetModelMatrix(), GL_LINES);
+    render_queue.Submit(color_pass, *main_z_line, main_z_line->GetModelMatrix(), GL_LINES);
 
     // draws the net
-    DrawOneNet(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), main_camera->GetViewProjection(), main_camera->GetPosition());
+    DrawOneNet(color_pass);
 
     // draws the rackets
-    DrawOneRacket(rackets[0].position, rackets[0].rotation, rackets[0].scale, main_camera->GetViewProjection(), main_camera->GetPosition(), 0);
-    DrawOneRacket(rackets[1].position, rackets[1].rotation + glm::vec3(0.0f, 180.0f, 0.0f), rackets[1].scale, main_camera->GetViewProjection(), main_camera->GetPosition(), 1);
+    DrawOneRacket(color_pass, 0);
+    DrawOneRacket(color_pass, 1);
+
+    render_queue.Submit(color_pass, *ground_plane, ground_plane->GetModelMatrix());
 
-    ground_plane->Draw(main_camera->GetViewProjection(), main_camera->GetPosition());
+    // sorts & draws everything that was recorded this frame
+    render_queue.Flush();
+
+    // the re-rendered layers are only cached if none of their casters were dropped, otherwise they stay dirty and are re-rendered next frame
+    if (render_queue.GetStats().dropped == 0)
+        CommitShadowLayers(shadow_layer_mask);
 
     // can be used for post-processing effects
     //main_screen->Draw();
 }
 
-void Renderer::DrawOneNet(const glm::vec3 &_position, const glm::vec3 &_rotation, const glm::vec3 &_scale, const glm::mat4& _viewProjection, const glm::vec3& _eyePosition, const Shader::Material *_materialOverride)
+void Renderer::UploadLights()
+{
+    Light::ShaderData lights_data[Light::MAX_LIGHTS] = {};
+
+    for (int i = 0; i < lights->size() && i < Light::MAX_LIGHTS; ++i) {
+        lights_data[i] = lights->at(i).GetShaderData();
+    }
+
+    lights_buffer->Upload(lights_data, sizeof(lights_data));
+}
+
+int Renderer::UpdateShadowLayers()
 {
+    // nothing casts shadows (or can't yet, the shadow mapper still compiling), so every layer will have to be re-rendered once shadows come back
+    if (!shadow_mode || !light_mode || !shadow_mapper_material->shader->IsReady()) {
+        for (auto& layer: shadow_layers)
+            layer.valid = false;
+
+        return 0;
+    }
+
+    // the rackets are the only casters that move, the net & the ground plane never do
+    const std::vector<glm::mat4> caster_transforms = { GetRacketTransform(0), GetRacketTransform(1) };
+    const bool has_previous_casters = shadow_caster_transforms.size() == caster_transforms.size();
+
+    int dirty_mask = 0;
+
+    for (int i = 0; i < lights->size() && i < Light::MAX_LIGHTS; ++i) {
+        const auto& light = lights->at(i);
+        auto& layer = shadow_layers[i];
+
+        // the lit shader ignores this layer, it will be re-rendered when the light projects shadows again
+        if (!light.project_shadows) {
+            layer.valid = false;
+            continue;
+        }
+
+        // the light moved (its position or target changed), so everything it sees changed
+        const glm::mat4 light_view_projection = light.GetViewProjection();
+        bool dirty = !layer.valid || !has_previous_casters || light_view_projection != layer.light_view_projection;
+
+        // a caster moved in (or out of) the light's view
+        if (!dirty) {
+            const Frustum light_frustum(light_view_projection);
+
+            for (int c = 0; c < caster_transforms.size() && !dirty; ++c) {
+                if (caster_transforms[c] == shadow_caster_transforms[c])
+                    continue;
+
+                // both where it was (to erase its old shadow) & where it is now
+                for (const auto& caster_transform: { shadow_caster_transforms[c], caster_transforms[c] }) {
+                    if (light_frustum.Intersects(racket_nodes[c].bounds.Transformed(caster_transform)))
+                        dirty = true;
+                }
+            }
+        }
+
+        // the layer is only cached once it's drawn, see CommitShadowLayers
+        if (dirty)
+            dirty_mask |= 1 << i;
+    }
+
+    shadow_caster_transforms = caster_transforms;
+
+    return dirty_mask;
+}
+
+void Renderer::CommitShadowLayers(int _layerMask)
+{
+    for (int i = 0; i < lights->size() && i < Light::MAX_LIGHTS; ++i) {
+        if (!(_layerMask & (1 << i)))
+            continue;
+
+        shadow_layers[i].valid = true;
+        shadow_layers[i].light_view_projection = lights->at(i).GetViewProjection();
+    }
+}
+
+glm::mat4 Renderer::GetRacketTransform(int _player) const
+{
+    return racket_nodes[_player].root->GetWorldMatrix();
+}
+
+void Renderer::DrawOneNet(int _pass, const Shader::Material *_materialOverride)
+{
+    // every net part is already laid out in its instance buffer, so each net material is a single draw call
+    for (auto& net_cube : net_cubes)
+    {
+        render_queue.SubmitInstanced(_pass, net_cube, net_node->GetWorldMatrix(), GL_TRIANGLES, _materialOverride);
+    }
+}
+
+void Renderer::SetupNetInstances(const int _horizontalNetCount, const int _verticalNetCount)
+{
+    // the net is static, so all of its parts are laid out once, relative to the net's own transform
     glm::mat4 world_transform_matrix = glm::mat4(1.0f);
-    // global transforms
-    world_transform_matrix = glm::translate(world_transform_matrix, _position);
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, _rotation);
-    world_transform_matrix = glm::scale(world_transform_matrix, _scale);
+
+    std::vector<glm::mat4> post_transforms;
+    std::vector<glm::mat4> net_transforms;
+    std::vector<glm::mat4> top_net_transforms;
 
     auto scale_factor = glm::vec3(0.0f);
 
     // first net post
     scale_factor = glm::vec3(1.0f, 8.0f, 1.0f);
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, -18.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    net_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+    post_transforms.push_back(glm::scale(world_transform_matrix, scale_factor));
 
     // horizontal net
-    auto h_net_count = 7;
-    scale_factor = glm::vec3(0.2f, 36.0f, 0.2f);
+    scale_factor = glm::vec3(0.2f, (float)_verticalNetCount, 0.2f);
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(-90.0f, 0.0f, 0.0f));
 
-    for (int i = 0; i < h_net_count - 1; ++i)
+    for (int i = 0; i < _horizontalNetCount - 1; ++i)
     {
         world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, -1.0f));
-        world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-        net_cubes[1].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
-        world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+        net_transforms.push_back(glm::scale(world_transform_matrix, scale_factor));
     }
 
     // first horizontal net (top)
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, -1.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    net_cubes[2].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+    top_net_transforms.push_back(glm::scale(world_transform_matrix, scale_factor));
 
     // vertical net
-    auto v_net_count = 36;
-    scale_factor = glm::vec3(0.2f, (float)(h_net_count - 1), 0.2f);
+    scale_factor = glm::vec3(0.2f, (float)(_horizontalNetCount - 1), 0.2f);
 
     // undo any movement from the horizontal net
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, (float)(h_net_count - 1)));
+    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, (float)(_horizontalNetCount - 1)));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(90.0f, 0.0f, 0.0f));
 
     // first half of the vertical net
-    for (int i = 0; i < v_net_count / 2; ++i)
+    for (int i = 0; i < _verticalNetCount / 2; ++i)
     {
         world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, 1.0f));
-        world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-        net_cubes[1].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
-        world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+        net_transforms.push_back(glm::scale(world_transform_matrix, scale_factor));
     }
 
     // second net post
-    scale_factor = glm::vec3(1.0f, 8.0f, 1.0f);
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, -1.0f, 0.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    net_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+    post_transforms.push_back(glm::scale(world_transform_matrix, glm::vec3(1.0f, 8.0f, 1.0f)));
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 1.0f, 0.0f));
 
     // rest of the vertical net
-    scale_factor = glm::vec3(0.2f, (float)(h_net_count - 1), 0.2f);
-    for (int i = v_net_count / 2; i < v_net_count; ++i)
+    for (int i = _verticalNetCount / 2; i < _verticalNetCount; ++i)
     {
         world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, 1.0f));
-        world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-        net_cubes[1].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
-        world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+        net_transforms.push_back(glm::scale(world_transform_matrix, scale_factor));
     }
 
     // third net post
-    scale_factor = glm::vec3(1.0f, 8.0f, 1.0f);
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, -1.0f, 0.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    net_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+    post_transforms.push_back(glm::scale(world_transform_matrix, glm::vec3(1.0f, 8.0f, 1.0f)));
+
+    net_cubes[0].SetInstances(post_transforms);
+    net_cubes[1].SetInstances(net_transforms);
+    net_cubes[2].SetInstances(top_net_transforms);
 }
 
-void Renderer::DrawOneRacket(const glm::vec3 &_position, const glm::vec3 &_rotation, const glm::vec3 &_scale, const glm::mat4& _viewProjection, const glm::vec3& _eyePosition, int _player, const Shader::Material *_materialOverride)
+void Renderer::DrawOneRacket(int _pass, int _player, const Shader::Material *_materialOverride)
 {
-    glm::mat4 world_transform_matrix = glm::mat4(1.0f);
-    // global transforms
-    world_transform_matrix = glm::translate(world_transform_matrix, _position);
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, _rotation);
-    world_transform_matrix = glm::scale(world_transform_matrix, _scale);
+    // the layered shadow mapper only takes triangles, so rackets drawn as lines or points still cast solid shadows
+    const int render_mode = _materialOverride == shadow_mapper_material.get() ? GL_TRIANGLES : racket_render_mode;
+
+    const auto& nodes = racket_nodes[_player];
+
+    // all world matrices are already up-to-date (see UpdateScene), so they're shared by every pass
+    // each letter is baked into a single mesh, without the faces hidden between its cubes
+    for (int i = 0; i < nodes.baked_letters.size(); ++i)
+        render_queue.Submit(_pass, *nodes.baked_letters[i], nodes.letter_roots[i]->GetWorldMatrix(), GL_TRIANGLES, _materialOverride);
+
+    // tennis ball
+    render_queue.Submit(_pass, *nodes.ball->drawable.object, nodes.ball->GetWorldMatrix(), render_mode, _materialOverride);
+
+    // the body is baked, so it's only one draw per shader & texture (or a single one, if all of it uses the same material)
+    if (_materialOverride != nullptr) {
+        render_queue.Submit(_pass, *nodes.baked_shadow_body, nodes.body->GetWorldMatrix(), render_mode, _materialOverride);
+    } else {
+        for (const auto& baked_body: nodes.baked_body)
+            render_queue.Submit(_pass, *baked_body, nodes.body->GetWorldMatrix(), render_mode);
+    }
+}
+
+void Renderer::BuildScene()
+{
+    scene_root = std::make_unique<SceneNode>();
 
-    glm::mat4 secondary_transform_matrix = world_transform_matrix;
+    // the net is static, its parts are already laid out in their instance buffers (see SetupNetInstances)
+    net_node = scene_root->AddChild();
+
+    // the racket roots follow the rackets' transforms, see UpdateScene
+    racket_nodes = std::vector<RacketNodes>(2);
+
+    for (int i = 0; i < racket_nodes.size(); ++i) {
+        BuildOneRacket(i);
+        BakeOneRacket(i);
+    }
+
+    UpdateScene();
+}
+
+void Renderer::UpdateScene()
+{
+    // only the racket roots can move, which only dirties their own subtree
+    for (int i = 0; i < racket_nodes.size(); ++i) {
+        // the second player faces the first one
+        const glm::vec3 rotation = i == 1 ? rackets[i].rotation + glm::vec3(0.0f, 180.0f, 0.0f) : rackets[i].rotation;
+
+        racket_nodes[i].root->SetTransform(rackets[i].position, rotation, rackets[i].scale);
+    }
+
+    scene_root->UpdateWorldMatrices();
+}
+
+void Renderer::BuildOneRacket(int _player)
+{
+    auto& nodes = racket_nodes[_player];
+
+    nodes.root = scene_root->AddChild();
+    nodes.body = nodes.root->AddChild();
 
     // letters
-    //player's letter
+    //player's letter, then the second one slightly smaller and further back
     switch (_player) {
         case 0:
-            DrawOneP(secondary_transform_matrix, _viewProjection, _eyePosition, _materialOverride);
+            nodes.letters = nodes.root->AddChild();
+            nodes.letter_roots = { nodes.letters->AddChild(), nodes.letters->AddChild(glm::vec3(0.0f, 2.5f, -2.0f) * 0.9f, glm::vec3(0.0f), glm::vec3(0.9f)) };
 
-            secondary_transform_matrix = glm::scale(secondary_transform_matrix, glm::vec3(0.9f));
-            secondary_transform_matrix = glm::translate(secondary_transform_matrix, glm::vec3(0.0f, 2.5f, -2.0f));
-
-            DrawOneI(secondary_transform_matrix, _viewProjection, _eyePosition, _materialOverride);
+            BuildOneP(nodes.letter_roots[0]);
+            BuildOneI(nodes.letter_roots[1]);
             break;
         case 1:
-            secondary_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(0.0f, 180.0f, 0.0f));
-            DrawOneN(secondary_transform_matrix, _viewProjection, _eyePosition, _materialOverride);
-
-            secondary_transform_matrix = glm::scale(secondary_transform_matrix, glm::vec3(0.9f));
-            secondary_transform_matrix = glm::translate(secondary_transform_matrix, glm::vec3(0.0f, 2.5f, -2.0f));
+            nodes.letters = nodes.root->AddChild(glm::vec3(0.0f), glm::vec3(0.0f, 180.0f, 0.0f));
+            nodes.letter_roots = { nodes.letters->AddChild(), nodes.letters->AddChild(glm::vec3(0.0f, 2.5f, -2.0f) * 0.9f, glm::vec3(0.0f), glm::vec3(0.9f)) };
 
-            DrawOneH(secondary_transform_matrix, _viewProjection, _eyePosition, _materialOverride);
+            BuildOneN(nodes.letter_roots[0]);
+            BuildOneH(nodes.letter_roots[1]);
             break;
     }
 
+    // every piece is a joint (translation & rotation, inherited by the next pieces) with a scaled cube under it (not inherited)
+    const auto add_piece = [this](SceneNode* _joint, const glm::vec3& _scale, int _material) {
+        _joint->AddChild(glm::vec3(0.0f), glm::vec3(0.0f), _scale, { augusto_racket_cube.get(), &augusto_racket_materials[_material] });
+    };
+
     // tennis ball
-    glm::mat4 third_transform_matrix = world_transform_matrix;
-    third_transform_matrix = glm::translate(third_transform_matrix, glm::vec3(1.0f, 14.0f, -3.0f));
-    third_transform_matrix = glm::scale(third_transform_matrix, glm::vec3(0.7f));
-    tennis_ball->DrawFromMatrix(_viewProjection, _eyePosition, third_transform_matrix, racket_render_mode, _materialOverride);
+    nodes.ball = nodes.root->AddChild(glm::vec3(1.0f, 14.0f, -3.0f), glm::vec3(0.0f), glm::vec3(0.7f), { tennis_ball.get() });
 
     // forearm (skin)
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(45.0f, 0.0f, 0.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(1.0f, 5.0f, 1.0f));
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                           nullptr ? &augusto_racket_materials[0] : _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(1.0f, 0.2f, 1.0f));
+    SceneNode* joint = nodes.body->AddChild(glm::vec3(0.0f), glm::vec3(45.0f, 0.0f, 0.0f));
+    add_piece(joint, glm::vec3(1.0f, 5.0f, 1.0f), 0);
 
     // arm (skin)
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 5.0f, 0.0f));
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(-45.0f, 0.0f, 0.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(1.0f, 4.0f, 1.0f));
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[0] : _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(1.0f, 0.25f, 1.0f));
+    joint = joint->AddChild(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(-45.0f, 0.0f, 0.0f));
+    add_piece(joint, glm::vec3(1.0f, 4.0f, 1.0f), 0);
 
     // racket handle (black plastic)
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 4.0f, 0.0f));
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(0.0f, 0.0f, 0.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 4.0f, 0.5f));
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[1] : _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 0.25f, 2.0f));
+    joint = joint->AddChild(glm::vec3(0.0f, 4.0f, 0.0f));
+    add_piece(joint, glm::vec3(0.5f, 4.0f, 0.5f), 1);
 
     // racket angled bottom left (blue plastic)
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 4.0f, 0.0f));
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(-60.0f, 0.0f, 0.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 2.0f, 0.5f));
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[2] : _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 0.5f, 2.0f));
+    joint = joint->AddChild(glm::vec3(0.0f, 4.0f, 0.0f), glm::vec3(-60.0f, 0.0f, 0.0f));
+    add_piece(joint, glm::vec3(0.5f, 2.0f, 0.5f), 2);
 
     // racket vertical left (green plastic)
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 2.0f, 0.0f));
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(60.0f, 0.0f, 0.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 3.0f, 0.5f));
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[3] : _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 1.0f / 3.0f, 2.0f));
+    joint = joint->AddChild(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(60.0f, 0.0f, 0.0f));
+    add_piece(joint, glm::vec3(0.5f, 3.0f, 0.5f), 3);
 
     // racket angled top left (blue plastic)
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 3.0f, 0.0f));
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(60.0f, 0.0f, 0.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 1.0f, 0.5f));
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[2] : _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 1.0f, 2.0f));
+    joint = joint->AddChild(glm::vec3(0.0f, 3.0f, 0.0f), glm::vec3(60.0f, 0.0f, 0.0f));
+    add_piece(joint, glm::vec3(0.5f, 1.0f, 0.5f), 2);
 
     // racket horizontal top (green plastic)
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 1.0f, 0.0));
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(30.0f, 0.0f, 0.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 1.6f, 0.5f));
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[3] : _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 1.0f / 1.6f, 2.0f));
+    joint = joint->AddChild(glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(30.0f, 0.0f, 0.0f));
+    add_piece(joint, glm::vec3(0.5f, 1.6f, 0.5f), 3);
 
     // racket angled top right (blue plastic)
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 1.6f, 0.0f));
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(30.0f, 0.0f, 0.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 1.0f, 0.5f));
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[2] : _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 1.0f, 2.0f));
+    joint = joint->AddChild(glm::vec3(0.0f, 1.6f, 0.0f), glm::vec3(30.0f, 0.0f, 0.0f));
+    add_piece(joint, glm::vec3(0.5f, 1.0f, 0.5f), 2);
 
     // racket vertical right (green plastic)
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 1.0f, 0.0f));
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(60.0f, 0.0f, 0.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 3.0f, 0.5f));
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[3] : _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 1.0f / 3.0f, 2.0f));
+    joint = joint->AddChild(glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(60.0f, 0.0f, 0.0f));
+    add_piece(joint, glm::vec3(0.5f, 3.0f, 0.5f), 3);
 
     // racket horizontal bottom (blue plastic)
     auto horizontal_bottom_scale = glm::vec3(0.4f, 3.2f, 0.4f);
 
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 3.0f, 0.0f));
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(90.0f, 0.0f, 0.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, horizontal_bottom_scale);
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[2] : _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / horizontal_bottom_scale);
+    joint = joint->AddChild(glm::vec3(0.0f, 3.0f, 0.0f), glm::vec3(90.0f, 0.0f, 0.0f));
+    add_piece(joint, horizontal_bottom_scale, 2);
 
     // racket net vertical (white plastic)
 
@@ -613,25 +766,11 @@ void Renderer::DrawOneRacket(const glm::vec3 &_position, const glm::vec3 &_rotat
     auto full_v_translate = net_first_v_translate + net_v_translate * (float)number_of_same_nets_v;
 
     // correct orientation for the vertical nets
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(90.0f, -90.0f, 0.0f));
-
-    // part 1
-    // done separately because it has a different offset (for aesthetic purposes)
-    world_transform_matrix = glm::translate(world_transform_matrix, net_first_v_translate);
-    world_transform_matrix = glm::scale(world_transform_matrix, net_v_scale);
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[4] : _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / net_v_scale);
-
-    // the rest of the net parts
-    for (int i = 0; i < number_of_same_nets_v; ++i)
-    {
-        world_transform_matrix = glm::translate(world_transform_matrix, net_v_translate);
-        world_transform_matrix = glm::scale(world_transform_matrix, net_v_scale);
-        augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                       nullptr ? &augusto_racket_materials[4] : _materialOverride);
-        world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / net_v_scale);
-    }
+    joint = joint->AddChild(glm::vec3(0.0f), glm::vec3(90.0f, -90.0f, 0.0f));
+
+    // part 1 has a different offset (for aesthetic purposes), the rest are evenly spaced
+    for (int i = 0; i <= number_of_same_nets_v; ++i)
+        joint->AddChild(net_first_v_translate + net_v_translate * (float)i, glm::vec3(0.0f), net_v_scale, { augusto_racket_cube.get(), &augusto_racket_materials[4] });
 
     // horizontal net parts
     int number_of_same_nets_h = 4;
@@ -640,197 +779,200 @@ void Renderer::DrawOneRacket(const glm::vec3 &_position, const glm::vec3 &_rotat
     auto net_h_scale = glm::vec3(0.1f, 3.05f, 0.1f);
     auto full_h_translate = net_first_h_translate + net_h_translate * (float)number_of_same_nets_h;
 
-    // correctly place and rotate the horizontal nets
+    // correctly place and rotate the horizontal nets, starting from the end of the vertical nets
     // the reason why it's a weird combination of y and z, is because we're always in relative space,
     // so depending on the current piece we're drawing, the orientation won't be the same
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(-horizontal_bottom_scale.z - full_v_translate.y, 0.0f, 0.0f));
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(0.0f, 0.0f, 90.0f));
-
-    // part 1
-    // done separately because it has a different offset (for aesthetic purposes)
-    world_transform_matrix = glm::translate(world_transform_matrix, net_first_h_translate);
-    world_transform_matrix = glm::scale(world_transform_matrix, net_h_scale);
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[4] : _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / net_h_scale);
-
-    // the rest of the net parts
-    for (int i = 0; i < number_of_same_nets_h; ++i)
-    {
-        world_transform_matrix = glm::translate(world_transform_matrix, net_h_translate);
-        world_transform_matrix = glm::scale(world_transform_matrix, net_h_scale);
-        augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                       nullptr ? &augusto_racket_materials[4] : _materialOverride);
-        world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / net_h_scale);
-    }
+    joint = joint->AddChild(full_v_translate + glm::vec3(-horizontal_bottom_scale.z - full_v_translate.y, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 90.0f));
+
+    // part 1 has a different offset (for aesthetic purposes), the rest are evenly spaced
+    for (int i = 0; i <= number_of_same_nets_h; ++i)
+        joint->AddChild(net_first_h_translate + net_h_translate * (float)i, glm::vec3(0.0f), net_h_scale, { augusto_racket_cube.get(), &augusto_racket_materials[4] });
 
     // racket angled bottom right (blue plastic)
-    // first we undo any transformations done for the net parts
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(-full_v_translate.x, horizontal_bottom_scale.y, 0.0f));
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(0.0f, 0.0f, 150.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 2.0f, 0.5f));
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[2] : _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 0.5f, 2.0f));
+    // starts from the end of the horizontal nets, undoing the offset of the vertical ones
+    joint = joint->AddChild(full_h_translate + glm::vec3(-full_v_translate.x, horizontal_bottom_scale.y, 0.0f), glm::vec3(0.0f, 0.0f, 150.0f));
+    add_piece(joint, glm::vec3(0.5f, 2.0f, 0.5f), 2);
 }
 
-// augusto letter A
-void Renderer::DrawOneA(glm::mat4 world_transform_matrix, const glm::mat4& _viewProjection,const glm::vec3& _eyePosition, const Shader::Material *_materialOverride)
+void Renderer::BakeOneRacket(int _player)
 {
-    auto scale_factor = glm::vec3(0.75f, 0.75f, 0.75f); // scale for one cube
+    auto& nodes = racket_nodes[_player];
 
-    // base transform
-    // rotating first, because we want to keep the original center of rotation
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(0.0f, 90.0f, 0.0f));
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(-scale_factor.x * 1.5f, 20.0f, 0.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(scale_factor));
+    // pieces are grouped by what can't change within a single draw (shader & texture)
+    // the materials of a group only differ by their color, each one gets its own id in the group's color palette
+    struct BakeGroup {
+        std::vector<const Shader::Material*> palette_materials;
+        std::vector<VisualBakedMesh::Piece> pieces;
+    };
 
-    // long left A vertical cubes
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    std::vector<BakeGroup> groups;
+    std::vector<VisualBakedMesh::Piece> shadow_pieces;
 
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 1.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    nodes.body->ForEachDrawable([&groups, &shadow_pieces, &nodes](const SceneNode& _node) {
+        const Shader::Material* material = _node.drawable.material != nullptr ? _node.drawable.material : &_node.drawable.object->material;
+        const glm::mat4 transform = _node.GetMatrixRelativeTo(nodes.body);
 
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 1.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+        auto group = std::find_if(groups.begin(), groups.end(), [material](const BakeGroup& _group) {
+            const bool is_in_palette = std::find(_group.palette_materials.begin(), _group.palette_materials.end(), material) != _group.palette_materials.end();
 
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 1.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+            return _group.palette_materials.front()->shader == material->shader && _group.palette_materials.front()->texture == material->texture &&
+                   (is_in_palette || _group.palette_materials.size() < Shader::MAX_COLOR_PALETTE_SIZE);
+        });
 
-    // short top A horizontal cubes
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(1.0f, 1.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+        if (group == groups.end())
+            group = groups.insert(groups.end(), BakeGroup());
 
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(1.0f, 0.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+        auto palette_entry = std::find(group->palette_materials.begin(), group->palette_materials.end(), material);
 
-    // long right A vertical cubes
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(1.0f, -1.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+        if (palette_entry == group->palette_materials.end())
+            palette_entry = group->palette_materials.insert(group->palette_materials.end(), material);
 
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, -1.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+        group->pieces.push_back({ _node.drawable.object, transform, (int)(palette_entry - group->palette_materials.begin()) });
+        shadow_pieces.push_back({ _node.drawable.object, transform, 0 });
+    });
 
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, -1.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    nodes.baked_body.clear();
 
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, -1.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    for (const auto& group: groups) {
+        Shader::Material baked_material = *group.palette_materials.front();
+
+        for (const auto* palette_material: group.palette_materials)
+            baked_material.color_palette.push_back(palette_material->color);
+
+        nodes.baked_body.push_back(std::make_unique<VisualBakedMesh>(group.pieces, baked_material));
+    }
+
+    nodes.baked_shadow_body = std::make_unique<VisualBakedMesh>(shadow_pieces);
+
+    nodes.baked_letters.clear();
+
+    for (const auto* letter_root: nodes.letter_roots)
+        nodes.baked_letters.push_back(BakeOneLetter(letter_root));
+
+    // the racket's bounds are merged from what was just baked, so that they follow its segments (used to find which shadows it moved through)
+    nodes.bounds = nodes.baked_shadow_body->GetBounds().Transformed(nodes.body->GetMatrixRelativeTo(nodes.root));
+    nodes.bounds = nodes.bounds.Merged(nodes.ball->drawable.object->GetBounds().Transformed(nodes.ball->GetMatrixRelativeTo(nodes.root)));
 
-    // short middle A horizontal cubes
+    for (int i = 0; i < nodes.baked_letters.size(); ++i)
+        nodes.bounds = nodes.bounds.Merged(nodes.baked_letters[i]->GetBounds().Transformed(nodes.letter_roots[i]->GetMatrixRelativeTo(nodes.root)));
+}
+
+std::unique_ptr<VisualObject> Renderer::BakeOneLetter(const SceneNode *_letter)
+{
+    // cubes that stay axis-aligned in the letter's space are filled into a voxel grid, the others (e.g. the N diagonal) are kept as they are
+    std::vector<VisualVoxelMesh::Box> boxes;
+    std::vector<VisualBakedMesh::Piece> oriented_pieces;
+    Shader::Material material;
+
+    _letter->ForEachDrawable([&boxes, &oriented_pieces, &material, _letter](const SceneNode& _node) {
+        const glm::mat4 transform = _node.GetMatrixRelativeTo(_letter);
+
+        //all cubes of a letter share its material
+        material = _node.drawable.material != nullptr ? *_node.drawable.material : _node.drawable.object->material;
+
+        if (Transforms::IsAxisAligned(transform)) {
+            const Bounds box = _node.drawable.object->GetBounds().Transformed(transform);
+            boxes.push_back({ box.min, box.max });
+        } else {
+            oriented_pieces.push_back({ _node.drawable.object, transform, 0 });
+        }
+    });
+
+    auto voxel_mesh = std::make_unique<VisualVoxelMesh>(boxes, LETTER_VOXEL_SIZE, material);
+
+    if (oriented_pieces.empty())
+        return voxel_mesh;
+
+    //the oriented cubes are merged with the voxel mesh, to keep a single draw per letter
+    oriented_pieces.push_back({ voxel_mesh.get(), glm::mat4(1.0f), 0 });
+
+    return std::make_unique<VisualBakedMesh>(oriented_pieces, material);
+}
+
+// augusto letter A
+void Renderer::BuildOneA(SceneNode *_parent)
+{
+    auto scale_factor = glm::vec3(0.75f, 0.75f, 0.75f); // scale for one cube
 
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(-1.0f, 2.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    // base transform
+    // rotating first, because we want to keep the original center of rotation
+    SceneNode* letter = _parent->AddChild(glm::vec3(0.0f), glm::vec3(0.0f, 90.0f, 0.0f));
+    letter = letter->AddChild(glm::vec3(-scale_factor.x * 1.5f, 20.0f, 0.0f), glm::vec3(0.0f), scale_factor);
+
+    // one cube per cell, in cube units
+    const glm::vec3 cells[] = {
+        // long left A vertical cubes
+        glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 3.0f, 0.0f),
+        // short top A horizontal cubes
+        glm::vec3(1.0f, 4.0f, 0.0f), glm::vec3(2.0f, 4.0f, 0.0f),
+        // long right A vertical cubes
+        glm::vec3(3.0f, 3.0f, 0.0f), glm::vec3(3.0f, 2.0f, 0.0f), glm::vec3(3.0f, 1.0f, 0.0f), glm::vec3(3.0f, 0.0f, 0.0f),
+        // short middle A horizontal cubes
+        glm::vec3(2.0f, 2.0f, 0.0f), glm::vec3(1.0f, 2.0f, 0.0f),
+    };
 
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(-1.0f, 0.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    for (const auto& cell: cells)
+        letter->AddChild(cell, glm::vec3(0.0f), glm::vec3(1.0f), { &letter_cubes[0] });
 }
 
-void Renderer::DrawOneP(glm::mat4 world_transform_matrix, const glm::mat4& _viewProjection, const glm::vec3& _eyePosition, const Shader::Material *_materialOverride) {
+void Renderer::BuildOneP(SceneNode *_parent) {
     //long P vertical
-    auto scale_factor = glm::vec3(0.5f, 5.0f, 0.5f);
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 20.0f, 0.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+    SceneNode* joint = _parent->AddChild(glm::vec3(0.0f, 20.0f, 0.0f));
+    joint->AddChild(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.5f, 5.0f, 0.5f), { &letter_cubes[0] });
 
     //short top P horizontal
-    scale_factor = glm::vec3(0.5f, 3.0f, 0.5f);
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 5.0f, 0.0f)); //translate to the end of the previous cube
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(0.0f, 0.0f, 90.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+    joint = joint->AddChild(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(0.0f, 0.0f, 90.0f)); //at the end of the previous cube
+    joint->AddChild(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.5f, 3.0f, 0.5f), { &letter_cubes[0] });
 
     //short right P vertical
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 3.0f, 0.0f)); //translate to the end of the previous cube
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(0.0f, 0.0f, 90.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+    joint = joint->AddChild(glm::vec3(0.0f, 3.0f, 0.0f), glm::vec3(0.0f, 0.0f, 90.0f)); //at the end of the previous cube
+    joint->AddChild(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.5f, 3.0f, 0.5f), { &letter_cubes[0] });
 
     //short bottom P horizontal
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 3.0f, 0.0f)); //translate to the end of the previous cube
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(0.0f, 0.0f, 90.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+    joint = joint->AddChild(glm::vec3(0.0f, 3.0f, 0.0f), glm::vec3(0.0f, 0.0f, 90.0f)); //at the end of the previous cube
+    joint->AddChild(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.5f, 3.0f, 0.5f), { &letter_cubes[0] });
 }
 
-void Renderer::DrawOneI(glm::mat4 world_transform_matrix, const glm::mat4& _viewProjection,const glm::vec3& _eyePosition, const Shader::Material *_materialOverride) {
+void Renderer::BuildOneI(SceneNode *_parent) {
     //short I bottom horizontal
-    auto scale_factor = glm::vec3(0.5f, 3.0f, 0.5f);
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(-1.5f, 20.0f, 0.0f));
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(0.0f, 0.0f, 90.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+    SceneNode* joint = _parent->AddChild(glm::vec3(-1.5f, 20.0f, 0.0f), glm::vec3(0.0f, 0.0f, 90.0f));
+    joint->AddChild(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.5f, 3.0f, 0.5f), { &letter_cubes[0] });
 
     //long I vertical
-    scale_factor = glm::vec3(0.5f, 5.0f, 0.5f);
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 1.5f, 0.0f)); //translate to the middle of the previous cube
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(0.0f, 0.0f, -90.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+    joint = joint->AddChild(glm::vec3(0.0f, 1.5f, 0.0f), glm::vec3(0.0f, 0.0f, -90.0f)); //at the middle of the previous cube
+    joint->AddChild(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.5f, 5.0f, 0.5f), { &letter_cubes[0] });
 
     //short I top horizontal
-    scale_factor = glm::vec3(0.5f, 3.0f, 0.5f);
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(-1.5f, 5.0f, 0.0f));
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(0.0f, 0.0f, 90.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+    joint = joint->AddChild(glm::vec3(-1.5f, 5.0f, 0.0f), glm::vec3(0.0f, 0.0f, 90.0f));
+    joint->AddChild(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.5f, 3.0f, 0.5f), { &letter_cubes[0] });
 }
 
-void Renderer::DrawOneN(glm::mat4 world_transform_matrix, const glm::mat4& _viewProjection,const glm::vec3& _eyePosition, const Shader::Material *_materialOverride) {
+void Renderer::BuildOneN(SceneNode *_parent) {
     //long N vertical
-    auto scale_factor = glm::vec3(0.5f, 5.0f, 0.5f);
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 20.0f, 0.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+    SceneNode* joint = _parent->AddChild(glm::vec3(0.0f, 20.0f, 0.0f));
+    joint->AddChild(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.5f, 5.0f, 0.5f), { &letter_cubes[0] });
 
     //long N diagonal
-    scale_factor = glm::vec3(0.5f, 7.07f, 0.5f);
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 5.0f, 0.0f)); //translate to the end of the previous cube
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(0.0f, 0.0f, -135.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+    joint = joint->AddChild(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(0.0f, 0.0f, -135.0f)); //at the end of the previous cube
+    joint->AddChild(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.5f, 7.07f, 0.5f), { &letter_cubes[0] });
 
     //long N vertical
-    scale_factor = glm::vec3(0.5f, 5.0f, 0.5f);
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 7.07f, 0.0f)); //translate to the end of the previous cube
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(0.0f, 0.0f, 135.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+    joint = joint->AddChild(glm::vec3(0.0f, 7.07f, 0.0f), glm::vec3(0.0f, 0.0f, 135.0f)); //at the end of the previous cube
+    joint->AddChild(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.5f, 5.0f, 0.5f), { &letter_cubes[0] });
 }
 
-void Renderer::DrawOneH(glm::mat4 world_transform_matrix, const glm::mat4& _viewProjection,const glm::vec3& _eyePosition, const Shader::Material *_materialOverride) {
+void Renderer::BuildOneH(SceneNode *_parent) {
     //long H left vertical
-    auto scale_factor = glm::vec3(0.5f, 5.0f, 0.5f);
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(-1.5f, 20.0f, 0.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+    SceneNode* joint = _parent->AddChild(glm::vec3(-1.5f, 20.0f, 0.0f));
+    joint->AddChild(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.5f, 5.0f, 0.5f), { &letter_cubes[0] });
 
     //short H middle horizontal
-    scale_factor = glm::vec3(0.5f, 3.0f, 0.5f);
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 2.5f, 0.0f)); //translate to the middle of the previous cube
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(0.0f, 0.0f, 90.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+    joint = joint->AddChild(glm::vec3(0.0f, 2.5f, 0.0f), glm::vec3(0.0f, 0.0f, 90.0f)); //at the middle of the previous cube
+    joint->AddChild(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.5f, 3.0f, 0.5f), { &letter_cubes[0] });
 
     //long H right vertical
-    scale_factor = glm::vec3(0.5f, 5.0f, 0.5f);
-    world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(2.5f, 3.0f, 0.0f));
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(0.0f, 0.0f, -90.0f));
-    world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+    joint = joint->AddChild(glm::vec3(2.5f, 3.0f, 0.0f), glm::vec3(0.0f, 0.0f, -90.0f));
+    joint->AddChild(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.5f, 5.0f, 0.5f), { &letter_cubes[0] });
 }
 
 void Renderer::ResizeCallback(GLFWwindow *_window, int _displayWidth, int _displayHeight)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <map>
 #include <utility>
 #include "Camera.h"
@@ -11,7 +12,12 @@
 #include "Visual/VisualCube.h"
 #include "Visual/VisualSphere.h"
 #include "Visual/VisualPlane.h"
+#include "Visual/VisualBakedMesh.h"
+#include "Visual/VisualVoxelMesh.h"
 #include "Screen.h"
+#include "RenderQueue.h"
+#include "SceneNode.h"
+#include "UniformBuffer.h"
 
 
 class Renderer
@@ -29,6 +35,8 @@ private:
         Transform(glm::vec3 _position, glm::vec3 _rotation, glm::vec3 _scale, glm::vec3 _target = glm::vec3(0.0f)) : position(_position), rotation(_rotation), scale(_scale), target(_target) {}
     };
 
+    RenderQueue render_queue;
+
     std::unique_ptr<Screen> main_screen;
     std::shared_ptr<Camera> main_camera;
     std::unique_ptr<Shader::Material> shadow_mapper_material;
@@ -40,6 +48,7 @@ private:
     std::unique_ptr<VisualLine> main_z_line;
 
     std::shared_ptr<std::vector<Light>> lights;
+    std::unique_ptr<UniformBuffer> lights_buffer;
     std::unique_ptr<VisualCube> main_light_cube;
     std::unique_ptr<VisualCube> world_cube;
     std::unique_ptr<VisualPlane> ground_plane;
@@ -53,6 +62,26 @@ private:
     std::shared_ptr<VisualCube> augusto_racket_cube;
     std::vector<Shader::Material> augusto_racket_materials;
 
+    // Scene hierarchy, its world matrices are updated once per frame and shared by all passes
+    struct RacketNodes
+    {
+        SceneNode* root = nullptr; //follows the racket's transform
+        SceneNode* letters = nullptr; //player's letters, always drawn as triangles
+        std::vector<SceneNode*> letter_roots; //one per letter, its cubes are baked relative to it
+        SceneNode* ball = nullptr; //tennis ball, drawn with the racket render mode
+        SceneNode* body = nullptr; //arm & racket, drawn with the racket render mode
+
+        std::vector<std::unique_ptr<VisualBakedMesh>> baked_body; //whole body, one mesh per shader & texture
+        std::unique_ptr<VisualBakedMesh> baked_shadow_body; //whole body as a single mesh, for the shadow pass
+        std::vector<std::unique_ptr<VisualObject>> baked_letters; //one mesh per letter root, without its hidden faces
+
+        Bounds bounds; //whole racket (body, letters & ball) relative to its root, updated whenever it's baked
+    };
+
+    std::unique_ptr<SceneNode> scene_root;
+    SceneNode* net_node = nullptr;
+    std::vector<RacketNodes> racket_nodes;
+
     std::vector<Transform> rackets;
     std::vector<Transform> default_rackets;
 
@@ -68,29 +97,47 @@ private:
     GLuint shadow_map_fbo = 0;
     GLuint shadow_map_texture = 0;
 
+    // Shadow caching: each layer of the shadow map is only re-rendered when its light, or a shadow caster in its view, changes
+    struct ShadowLayer
+    {
+        bool valid = false; //false until the layer is rendered, and whenever its content can't be trusted anymore
+        glm::mat4 light_view_projection = glm::mat4(1.0f); //light view the layer was rendered with
+    };
+
+    std::array<ShadowLayer, Light::MAX_LIGHTS> shadow_layers;
+    std::vector<glm::mat4> shadow_caster_transforms; //transforms of the moving shadow casters (the rackets) at the last shadow update
+
+    //letter cubes are snapped to this grid when baked, all of their sizes & offsets are multiples of it
+    constexpr static float LETTER_VOXEL_SIZE = 0.125f;
+
 public:
     Renderer(int _initialWidth, int _initialHeight);
 
     void Init();
     void Render(GLFWwindow *_window, double _deltaTime);
 
-    void DrawOneNet(const glm::vec3 &_position, const glm::vec3 &_rotation, const glm::vec3 &_scale, const glm::mat4& _viewProjection, const glm::vec3& _eyePosition, const Shader::Material *_materialOverride = nullptr);
-    void DrawOneRacket(const glm::vec3 &_position, const glm::vec3 &_rotation, const glm::vec3 &_scale, const glm::mat4 &_viewProjection, const glm::vec3 &_eyePosition, int _player, const Shader::Material *_materialOverride = nullptr);
-
-    void DrawOneA(glm::mat4 world_transform_matrix, const glm::mat4& _viewProjection,const glm::vec3& _eyePosition, const Shader::Material *_materialOverride = nullptr);
+    void UploadLights();
+    int UpdateShadowLayers(); //returns the mask of the shadow map layers that have to be re-rendered this frame
+    void CommitShadowLayers(int _layerMask); //caches the given layers, once they're drawn
 
-    void ResizeCallback(GLFWwindow *_window, int _displayWidth, int _displayHeight);
-    void InputCallback(GLFWwindow *_window, double _deltaTime);
+    [[nodiscard]] glm::mat4 GetRacketTransform(int _player) const;
 
-    void DrawOneP(glm::mat4 world_transform_matrix, const glm::mat4 &_viewProjection, const glm::vec3 &_eyePosition,
-                  const Shader::Material *_materialOverride);
+    void BuildScene();
+    void UpdateScene(); //copies the rackets' transforms to their nodes, then updates the world matrices of what moved
 
-    void DrawOneI(glm::mat4 world_transform_matrix, const glm::mat4 &_viewProjection, const glm::vec3 &_eyePosition,
-                  const Shader::Material *_materialOverride);
+    void DrawOneNet(int _pass, const Shader::Material *_materialOverride = nullptr);
+    void SetupNetInstances(int _horizontalNetCount, int _verticalNetCount);
+    void DrawOneRacket(int _pass, int _player, const Shader::Material *_materialOverride = nullptr);
+    void BuildOneRacket(int _player);
+    void BakeOneRacket(int _player); //merges the racket's body & letters, has to be called again whenever one of their segments moves
+    std::unique_ptr<VisualObject> BakeOneLetter(const SceneNode *_letter);
 
-    void DrawOneN(glm::mat4 world_transform_matrix, const glm::mat4 &_viewProjection, const glm::vec3 &_eyePosition,
-                  const Shader::Material *_materialOverride);
+    void ResizeCallback(GLFWwindow *_window, int _displayWidth, int _displayHeight);
+    void InputCallback(GLFWwindow *_window, double _deltaTime);
 
-    void DrawOneH(glm::mat4 world_transform_matrix, const glm::mat4 &_viewProjection, const glm::vec3 &_eyePosition,
-                  const Shader::Material *_materialOverride);
+    void BuildOneA(SceneNode *_parent);
+    void BuildOneP(SceneNode *_parent);
+    void BuildOneI(SceneNode *_parent);
+    void BuildOneN(SceneNode *_parent);
+    void BuildOneH(SceneNode *_parent);
 };
@@ -0,0 +1,91 @@
+#include "SceneNode.h"
+
+#include "Utility/Transform.hpp"
+
+SceneNode::SceneNode(glm::vec3 _position, glm::vec3 _rotation, glm::vec3 _scale, Drawable _drawable) {
+    position = _position;
+    rotation = _rotation;
+    scale = _scale;
+
+    drawable = _drawable;
+}
+
+SceneNode *SceneNode::AddChild(glm::vec3 _position, glm::vec3 _rotation, glm::vec3 _scale, Drawable _drawable) {
+    children.push_back(std::make_unique<SceneNode>(_position, _rotation, _scale, _drawable));
+
+    SceneNode *child = children.back().get();
+    child->parent = this;
+    child->MarkDirty();
+
+    return child;
+}
+
+void SceneNode::SetTransform(const glm::vec3 &_position, const glm::vec3 &_rotation, const glm::vec3 &_scale) {
+    if (position == _position && rotation == _rotation && scale == _scale)
+        return;
+
+    position = _position;
+    rotation = _rotation;
+    scale = _scale;
+
+    MarkDirty();
+}
+
+void SceneNode::MarkDirty() {
+    dirty = true;
+
+    //lets the ancestors know that something below them has to be updated, stopping at the first one that already knows
+    for (SceneNode *ancestor = parent; ancestor != nullptr && !ancestor->dirty_descendants; ancestor = ancestor->parent)
+        ancestor->dirty_descendants = true;
+}
+
+void SceneNode::UpdateWorldMatrices() {
+    UpdateWorldMatrices(false);
+}
+
+void SceneNode::UpdateWorldMatrices(bool _parentChanged) {
+    //nothing changed in this subtree, so all of its cached matrices are still valid
+    if (!dirty && !dirty_descendants && !_parentChanged)
+        return;
+
+    const bool changed = dirty || _parentChanged;
+
+    if (changed)
+        world_matrix = parent != nullptr ? parent->world_matrix * GetLocalMatrix() : GetLocalMatrix();
+
+    for (auto &child: children)
+        child->UpdateWorldMatrices(changed);
+
+    dirty = false;
+    dirty_descendants = false;
+}
+
+const glm::mat4 &SceneNode::GetWorldMatrix() const {
+    return world_matrix;
+}
+
+glm::mat4 SceneNode::GetLocalMatrix() const {
+    glm::mat4 local_matrix = glm::mat4(1.0f);
+    local_matrix = glm::translate(local_matrix, position);
+    local_matrix = Transforms::RotateDegrees(local_matrix, rotation);
+    local_matrix = glm::scale(local_matrix, scale);
+
+    return local_matrix;
+}
+
+glm::mat4 SceneNode::GetMatrixRelativeTo(const SceneNode *_ancestor) const {
+    glm::mat4 relative_matrix = glm::mat4(1.0f);
+
+    for (const SceneNode *node = this; node != nullptr && node != _ancestor; node = node->parent)
+        relative_matrix = node->GetLocalMatrix() * relative_matrix;
+
+    return relative_matrix;
+}
+
+void SceneNode::ForEachDrawable(const std::function<void(const SceneNode &)> &_function) const {
+    if (drawable.object != nullptr)
+        _function(*this);
+
+    for (const auto &child: children)
+        child->ForEachDrawable(_function);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include "glm/vec3.hpp"
+#include "glm/mat4x4.hpp"
+#include "Shader.h"
+#include "Visual/VisualObject.h"
+
+// A node of the scene hierarchy: a transform relative to its parent, and optionally something to draw with it
+// World matrices are cached, and only recomputed when the node or one of its ancestors changed
+class SceneNode {
+public:
+    // What's drawn at this node, with the node's world matrix
+    // value-initialized (i.e. Drawable()), it draws nothing
+    struct Drawable {
+        const VisualObject *object; // nothing is drawn if null
+        const Shader::Material *material; // the object's own material if null
+    };
+
+    Drawable drawable;
+
+private:
+    // Local transform, applied like VisualObject's (translation, then rotation in degrees, then scale)
+    glm::vec3 position, rotation, scale;
+
+    SceneNode *parent = nullptr;
+    std::vector<std::unique_ptr<SceneNode>> children;
+
+    glm::mat4 world_matrix = glm::mat4(1.0f);
+    bool dirty = true; // this node's world matrix (and its whole subtree's) is out of date
+    bool dirty_descendants = false; // at least one node of the subtree is dirty
+
+public:
+    explicit SceneNode(glm::vec3 _position = glm::vec3(0.0f), glm::vec3 _rotation = glm::vec3(0.0f), glm::vec3 _scale = glm::vec3(1.0f), Drawable _drawable = Drawable());
+
+    SceneNode *AddChild(glm::vec3 _position = glm::vec3(0.0f), glm::vec3 _rotation = glm::vec3(0.0f), glm::vec3 _scale = glm::vec3(1.0f), Drawable _drawable = Drawable());
+
+    // only marks the node as dirty if the transform actually changed
+    void SetTransform(const glm::vec3 &_position, const glm::vec3 &_rotation, const glm::vec3 &_scale);
+
+    void UpdateWorldMatrices(); // recomputes the world matrices of the dirty nodes of this subtree (meant to be called once per frame on the root)
+
+    [[nodiscard]] const glm::mat4 &GetWorldMatrix() const;
+    [[nodiscard]] glm::mat4 GetLocalMatrix() const;
+    [[nodiscard]] glm::mat4 GetMatrixRelativeTo(const SceneNode *_ancestor) const; // transform from this node's space to one of its ancestors' space
+
+    void ForEachDrawable(const std::function<void(const SceneNode &)> &_function) const; // visits all the nodes of this subtree that draw something
+
+private:
+    void MarkDirty();
+    void UpdateWorldMatrices(bool _parentChanged);
+};
@@ -1,4 +1,9 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include "Shader.h"
+#include "Utility/MappedFile.hpp"
 
 Shader::Shader(uint32_t _vertexShaderId, uint32_t _fragmentShaderId, uint32_t _programId) {
     vertex_shader_id = _vertexShaderId;
@@ -10,77 +15,186 @@ void Shader::Use() const {
     glUseProgram(program_id);
 }
 
-void Shader::SetBool(const char *_name, bool _value) const {
-    glProgramUniform1ui(program_id, glGetUniformLocation(program_id, _name), (int) _value);
+bool Shader::IsReady() const {
+    return ready;
 }
 
-void Shader::SetInt(const char *_name, int _value) const {
-    glProgramUniform1i(program_id, glGetUniformLocation(program_id, _name), _value);
+const Shader &Shader::GetVariant(const Shader::Permutation &_permutation) {
+    if (permutation_features == 0)
+        return *this;
+
+    const uint32_t key = _permutation.GetKey(permutation_features);
+    auto variant = variants.find(key);
+
+    if (variant == variants.end())
+        variant = variants.emplace(key, Shader::Library::CreateVariant(*this, _permutation)).first;
+
+    //the general program is drawn until the variant is done, so nothing disappears while it compiles
+    return variant->second->IsReady() ? *variant->second : *this;
 }
 
-void Shader::SetFloat(const char *_name, float _value) const {
-    glProgramUniform1f(program_id, glGetUniformLocation(program_id, _name), _value);
+uint32_t Shader::Permutation::GetKey(uint32_t _features) const {
+    uint32_t key = 0;
+
+    if (_features & LIGHTS)
+        key |= (uint32_t)light_count | (spot_light_mask & 0xFF) << 8;
+
+    if (_features & SHADOWS)
+        key |= (uint32_t)shadows << 16;
+
+    if (_features & TEXTURE)
+        key |= (uint32_t)texture << 17;
+
+    return key;
 }
 
-void Shader::SetFloatFast(const char *_name, float _value) const {
-    glUniform1f(glGetUniformLocation(program_id, _name), _value);
+std::string Shader::Permutation::GetDefines(uint32_t _features) const {
+    std::string defines;
+
+    if (_features & LIGHTS) {
+        defines.append("#define LIGHT_COUNT ").append(std::to_string(light_count)).append("\n");
+        defines.append("#define SPOT_LIGHT_MASK ").append(std::to_string(spot_light_mask & 0xFF)).append("\n");
+    }
+
+    if (_features & SHADOWS)
+        defines.append("#define SHADOWS ").append(shadows ? "1" : "0").append("\n");
+
+    if (_features & TEXTURE)
+        defines.append("#define TEXTURE ").append(texture ? "1" : "0").append("\n");
+
+    return defines;
 }
 
-void Shader::SetVec2(const char *_name, float _valueX, float _valueY) const {
-    glProgramUniform2f(program_id, glGetUniformLocation(program_id, _name), _valueX, _valueY);
+void Shader::ReflectUniforms() {
+    uniform_locations.clear();
+
+    GLint uniform_count = 0, max_name_length = 0;
+    glGetProgramiv(program_id, GL_ACTIVE_UNIFORMS, &uniform_count);
+    glGetProgramiv(program_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+
+    std::vector<char> name_buffer(max_name_length + 1);
+
+    // keeps track of the name behind every hash, to catch any collision
+    std::unordered_map<uint32_t, std::string> names;
+
+    auto add_location = [&](const std::string &_name) {
+        const GLint location = glGetUniformLocation(program_id, _name.c_str());
+
+        // uniforms inside uniform blocks have no location
+        if (location < 0)
+            return;
+
+        const auto hash = Uniform::Hash(_name);
+
+        if (names.contains(hash) && names[hash] != _name) {
+            std::cout << "ERROR::SHADER::PROGRAM::UNIFORM_HASH_COLLISION -> (" << program_id << ") " << names[hash] << " & " << _name << std::endl;
+        }
+
+        names[hash] = _name;
+        uniform_locations[hash] = location;
+    };
+
+    for (GLint i = 0; i < uniform_count; ++i) {
+        GLsizei name_length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program_id, i, (GLsizei)name_buffer.size(), &name_length, &size, &type, name_buffer.data());
+
+        const std::string name(name_buffer.data(), name_length);
+
+        add_location(name);
+
+        // arrays of basic types are reported once, as "name[0]", so every element (and the array itself) is added too
+        if (name.ends_with("[0]")) {
+            const std::string array_name = name.substr(0, name.size() - 3);
+
+            add_location(array_name);
+
+            for (GLint element = 1; element < size; ++element) {
+                add_location(array_name + "[" + std::to_string(element) + "]");
+            }
+        }
+    }
 }
 
-void Shader::SetVec2(const char *_name, const glm::vec2 &_value) const {
-    glProgramUniform2f(program_id, glGetUniformLocation(program_id, _name), _value.x, _value.y);
+void Shader::BindUniformBlocks() const {
+    struct UniformBlock {
+        const char *name;
+        GLuint binding;
+    };
+
+    constexpr UniformBlock shared_blocks[] = {
+        {"LightsBlock", LIGHTS_BLOCK_BINDING},
+        {"ViewBlock", VIEW_BLOCK_BINDING},
+    };
+
+    for (const auto &block: shared_blocks) {
+        const GLuint block_index = glGetUniformBlockIndex(program_id, block.name);
+
+        // not every program uses every block
+        if (block_index != GL_INVALID_INDEX)
+            glUniformBlockBinding(program_id, block_index, block.binding);
+    }
+
+    // per-draw data is too big for a uniform block once a whole multi-draw reads it, so it's a storage block
+    const GLuint object_block_index = glGetProgramResourceIndex(program_id, GL_SHADER_STORAGE_BLOCK, "ObjectBlock");
+
+    if (object_block_index != GL_INVALID_INDEX)
+        glShaderStorageBlockBinding(program_id, object_block_index, OBJECT_BLOCK_BINDING);
 }
 
-void Shader::SetVec3(const char *_name, float _valueX, float _valueY, float _valueZ) const {
-    glProgramUniform3f(program_id, glGetUniformLocation(program_id, _name), _valueX, _valueY, _valueZ);
+GLint Shader::GetUniformLocation(Uniform _uniform) const {
+    const auto location = uniform_locations.find(_uniform.hash);
+
+    return location != uniform_locations.end() ? location->second : -1;
 }
 
-void Shader::SetVec3(const char *_name, const glm::vec3& _value) const {
-    glProgramUniform3f(program_id, glGetUniformLocation(program_id, _name), _value.x, _value.y, _value.z);
+Shader::Uniform Shader::Uniform::FromString(std::string_view _name) {
+    return Uniform(Hash(_name), true);
 }
 
-void Shader::SetTexture(const char *_name, GLint _value) const {
-    SetInt(_name, _value);
+void Shader::SetBool(Uniform _uniform, bool _value) const {
+    glProgramUniform1ui(program_id, GetUniformLocation(_uniform), (int) _value);
 }
 
-void Shader::SetMat4(const char *_name, const glm::mat4 &_value) const {
-    glProgramUniformMatrix4fv(program_id, glGetUniformLocation(program_id, _name), 1, GL_FALSE, glm::value_ptr(_value));
+void Shader::SetInt(Uniform _uniform, int _value) const {
+    glProgramUniform1i(program_id, GetUniformLocation(_uniform), _value);
 }
 
-void Shader::SetModelMatrix(const glm::mat4 &_transform) const {
-    glProgramUniformMatrix4fv(program_id, glGetUniformLocation(program_id, "u_model_transform"), 1, GL_FALSE, glm::value_ptr(_transform));
+void Shader::SetFloat(Uniform _uniform, float _value) const {
+    glProgramUniform1f(program_id, GetUniformLocation(_uniform), _value);
 }
 
-void Shader::SetViewProjectionMatrix(const glm::mat4 &_transform) const {
-    glProgramUniformMatrix4fv(program_id, glGetUniformLocation(program_id, "u_view_projection"), 1, GL_FALSE, glm::value_ptr(_transform));
+void Shader::SetFloatFast(Uniform _uniform, float _value) const {
+    glUniform1f(GetUniformLocation(_uniform), _value);
 }
 
-void Shader::ApplyLightsToShader(const std::shared_ptr<std::vector<Light>> _lights) const {
-    // shadow map consumption
-    SetTexture("u_depth_texture", 0);
+void Shader::SetVec2(Uniform _uniform, float _valueX, float _valueY) const {
+    glProgramUniform2f(program_id, GetUniformLocation(_uniform), _valueX, _valueY);
+}
 
-    for (int i = 0; i < _lights->size(); ++i) {
-        const auto& light = _lights->at(i);
-        const auto i_string = std::to_string(i);
+void Shader::SetVec2(Uniform _uniform, const glm::vec2 &_value) const {
+    glProgramUniform2f(program_id, GetUniformLocation(_uniform), _value.x, _value.y);
+}
 
-        SetVec3(("u_lights[" + i_string + "].position").c_str(), light.GetPosition());
-        SetVec3(("u_lights[" + i_string + "].color").c_str(), light.GetColor());
+void Shader::SetVec3(Uniform _uniform, float _valueX, float _valueY, float _valueZ) const {
+    glProgramUniform3f(program_id, GetUniformLocation(_uniform), _valueX, _valueY, _valueZ);
+}
 
-        SetFloatFast(("u_lights[" + i_string + "].point_spot_influence").c_str(), light.type == Light::Type::POINT ? 0.0f : 1.0f);
-        SetFloatFast(("u_lights[" + i_string + "].shadows_influence").c_str(), 1.0f - (float)light.project_shadows);
-        SetVec3(("u_lights[" + i_string + "].attenuation").c_str(), light.attenuation);
+void Shader::SetVec3(Uniform _uniform, const glm::vec3& _value) const {
+    glProgramUniform3f(program_id, GetUniformLocation(_uniform), _value.x, _value.y, _value.z);
+}
 
-        SetFloatFast(("u_lights[" + i_string + "].ambient_strength").c_str(), light.ambient_strength);
-        SetFloatFast(("u_lights[" + i_string + "].specular_strength").c_str(), light.specular_strength);
+void Shader::SetVec3Array(Uniform _uniform, const std::vector<glm::vec3>& _values) const {
+    glProgramUniform3fv(program_id, GetUniformLocation(_uniform), (GLsizei)_values.size(), glm::value_ptr(_values.front()));
+}
 
-        SetVec3(("u_lights[" + i_string + "].spot_dir").c_str(), light.GetSpotlightDirection());
-        SetFloatFast(("u_lights[" + i_string + "].spot_cutoff").c_str(), light.GetSpotlightCutoff());
+void Shader::SetTexture(Uniform _uniform, GLint _value) const {
+    SetInt(_uniform, _value);
+}
 
-        SetMat4(("u_lights[" + i_string + "].light_view_projection").c_str(), light.GetViewProjection());
-    }
+void Shader::SetMat4(Uniform _uniform, const glm::mat4 &_value) const {
+    glProgramUniformMatrix4fv(program_id, GetUniformLocation(_uniform), 1, GL_FALSE, glm::value_ptr(_value));
 }
 
 Shader::Library::Library() {
@@ -88,39 +202,20 @@ Shader::Library::Library() {
     Shader::Library::compiled_shader_library = std::unordered_map<std::string, std::shared_ptr<Shader>>();
 }
 
-std::shared_ptr<Shader> Shader::Library::CreateShader(const std::string& _vertexShaderPath, const std::string& _fragmentShaderPath) {
-    std::string shaderCode;
-    uint32_t vertex_id;
-    uint32_t fragment_id;
-    std::shared_ptr<Shader> compiled_shader;
+std::shared_ptr<Shader> Shader::Library::CreateShader(const std::string& _vertexShaderPath, const std::string& _fragmentShaderPath, uint32_t _permutationFeatures) {
+    //the features are part of the program's name, so that creating it with other features (or none) gives another program, with its own variants
+    const std::string features_name = _permutationFeatures != 0 ? "@" + std::to_string(_permutationFeatures) : "";
 
-    if (Shader::Library::shader_library.contains(_vertexShaderPath)) {
-        vertex_id = Shader::Library::shader_library[_vertexShaderPath];
-    } else {
-        shaderCode = Shader::Library::ReadShaderCode(_vertexShaderPath);
-
-        vertex_id = Shader::Library::AddShader(_vertexShaderPath, GL_VERTEX_SHADER, 1, shaderCode.c_str());
-    }
-
-    if (Shader::Library::shader_library.contains(_fragmentShaderPath)) {
-        fragment_id = Shader::Library::shader_library[_fragmentShaderPath];
-    } else {
-        shaderCode = Shader::Library::ReadShaderCode(_fragmentShaderPath);
-
-        fragment_id = Shader::Library::AddShader(_fragmentShaderPath, GL_FRAGMENT_SHADER, 1, shaderCode.c_str());
-    }
-
-    auto shader_name = std::to_string(vertex_id).append("-").append(std::to_string(fragment_id));
-
-    if (Shader::Library::compiled_shader_library.contains(shader_name)) {
-        compiled_shader = Shader::Library::compiled_shader_library[shader_name];
-    } else {
-        compiled_shader = Shader::Library::AddProgram(shader_name, vertex_id, fragment_id);
-    }
+    std::shared_ptr<Shader> compiled_shader = Shader::Library::CreateCachedProgram({ { _vertexShaderPath, GL_VERTEX_SHADER }, { _fragmentShaderPath, GL_FRAGMENT_SHADER } }, "", features_name);
+    compiled_shader->permutation_features = _permutationFeatures; //the same for every program of that name
 
     return compiled_shader;
 }
 
+std::shared_ptr<Shader> Shader::Library::CreateShader(const std::string& _vertexShaderPath, const std::string& _geometryShaderPath, const std::string& _fragmentShaderPath) {
+    return Shader::Library::CreateCachedProgram({ { _vertexShaderPath, GL_VERTEX_SHADER }, { _geometryShaderPath, GL_GEOMETRY_SHADER }, { _fragmentShaderPath, GL_FRAGMENT_SHADER } });
+}
+
 std::shared_ptr<Shader> Shader::Library::CreateShader(uint32_t _vertexShaderId, uint32_t _fragmentShaderId) {
     auto vertexShaderIdCString = std::to_string(_vertexShaderId);
     auto fragmentShaderIdCString = std::to_string(_fragmentShaderId);
@@ -135,54 +230,210 @@ std::shared_ptr<Shader> Shader::Library::CreateShader(uint32_t _vertexShaderId,
 uint32_t
 Shader::Library::AddShader(const std::string& _name, GLenum _type, GLsizei _count, const char* _code, const GLint* _length) {
     uint32_t shader_id;
-    int success;
-    char log[512];
 
+    IsParallelCompileSupported();
+
+    //only submitted, the status is checked once the program using it is done (see Finish)
     shader_id = glCreateShader(_type);
     glShaderSource(shader_id, _count, &_code, _length);
     glCompileShader(shader_id);
 
-    //error printing, if any
-    glGetShaderiv(shader_id, GL_COMPILE_STATUS, &success);
-
-    if (!success) {
-        glGetShaderInfoLog(shader_id, 512, nullptr, log);
-
-        std::cout << "ERROR::SHADER::" << ((_type == GL_VERTEX_SHADER) ? "VERTEX" : "FRAGMENT")
-                  << "::COMPILATION_FAILED -> (" << _name << ") " << log << std::endl;
-    }
-
     Shader::Library::shader_library[_name] = shader_id;
 
     return shader_id;
 }
 
-std::shared_ptr<Shader> Shader::Library::AddProgram(const std::string& _name, uint32_t _vertexId, uint32_t _fragmentId) {
+std::shared_ptr<Shader> Shader::Library::AddProgram(const std::string& _name, uint32_t _vertexId, uint32_t _fragmentId, uint32_t _geometryId) {
+    return AddProgram(_name, _vertexId, _fragmentId, _geometryId, "");
+}
+
+std::shared_ptr<Shader> Shader::Library::AddProgram(const std::string& _name, uint32_t _vertexId, uint32_t _fragmentId, uint32_t _geometryId, const std::string& _cacheKey) {
     int program_id;
-    int success;
-    char log[512];
 
     program_id = glCreateProgram();
+
+    // lets the driver know the binary will be asked for, to be cached
+    glProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
     glAttachShader(program_id, _vertexId);
     glAttachShader(program_id, _fragmentId);
+
+    if (_geometryId != 0)
+        glAttachShader(program_id, _geometryId);
+
+    //only submitted too, the program isn't ready until PollPending() finishes it
     glLinkProgram(program_id);
 
+    std::shared_ptr<Shader> compiled_shader = std::make_shared<Shader>(_vertexId, _fragmentId, program_id);
+    compiled_shader->geometry_shader_id = _geometryId;
+
+    Shader::Library::compiled_shader_library[_name] = compiled_shader;
+    Shader::Library::pending_programs.push_back({ _name, compiled_shader, _cacheKey });
+
+    return compiled_shader;
+}
+
+void Shader::Library::PollPending() {
+    std::erase_if(Shader::Library::pending_programs, [](const PendingProgram &_program) {
+        if (!IsDone(_program))
+            return false;
+
+        Finish(_program);
+        return true;
+    });
+}
+
+bool Shader::Library::IsCompiling() {
+    return !Shader::Library::pending_programs.empty();
+}
+
+std::shared_ptr<Shader> Shader::Library::CreateVariant(const Shader& _shader, const Shader::Permutation& _permutation) {
+    const uint32_t key = _permutation.GetKey(_shader.permutation_features);
+
+    //keys only cover the given features, so programs created with different ones can't share their variants
+    return Shader::Library::CreateCachedProgram(_shader.stage_paths, _permutation.GetDefines(_shader.permutation_features), "@" + std::to_string(_shader.permutation_features) + "#" + std::to_string(key));
+}
+
+bool Shader::Library::IsParallelCompileSupported() {
+    if (!Shader::Library::parallel_compile.has_value()) {
+        Shader::Library::parallel_compile = GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile;
+
+        //as many compiler threads as the driver sees fit
+        if (GLAD_GL_KHR_parallel_shader_compile)
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        else if (GLAD_GL_ARB_parallel_shader_compile)
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+    }
+
+    return *Shader::Library::parallel_compile;
+}
+
+bool Shader::Library::IsDone(const Shader::Library::PendingProgram &_program) {
+    //without the extension, there's no way to know without waiting, so the programs are finished right away (like they used to be compiled)
+    if (!IsParallelCompileSupported())
+        return true;
+
+    // the program completes once its stages compiled & it linked
+    int done = 0;
+    glGetProgramiv(_program.shader->program_id, GL_COMPLETION_STATUS_KHR, &done);
+
+    return done;
+}
+
+void Shader::Library::Finish(const Shader::Library::PendingProgram &_program) {
+    Shader &shader = *_program.shader;
+    int success;
+    char log[512];
+
     //error printing, if any
-    glGetProgramiv(program_id, GL_LINK_STATUS, &success);
+    for (const uint32_t shader_id: { shader.vertex_shader_id, shader.geometry_shader_id, shader.fragment_shader_id }) {
+        if (shader_id == 0)
+            continue;
+
+        glGetShaderiv(shader_id, GL_COMPILE_STATUS, &success);
+
+        if (!success) {
+            GLint type = 0;
+            glGetShaderiv(shader_id, GL_SHADER_TYPE, &type);
+            glGetShaderInfoLog(shader_id, 512, nullptr, log);
+
+            std::cout << "ERROR::SHADER::" << ((type == GL_VERTEX_SHADER) ? "VERTEX" : (type == GL_GEOMETRY_SHADER) ? "GEOMETRY" : "FRAGMENT")
+                      << "::COMPILATION_FAILED -> (" << _program.name << ") " << log << std::endl;
+        }
+    }
+
+    glGetProgramiv(shader.program_id, GL_LINK_STATUS, &success);
 
+    // a program that didn't link is never drawn
     if (!success) {
-        glGetShaderInfoLog(program_id, 512, nullptr, log);
+        glGetProgramInfoLog(shader.program_id, 512, nullptr, log);
 
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED -> (" << _name << ") " << log << std::endl;
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED -> (" << _program.name << ") " << log << std::endl;
+        return;
     }
 
-    std::shared_ptr<Shader> compiled_shader = std::make_shared<Shader>(_vertexId, _fragmentId, program_id);
+    shader.ReflectUniforms();
+    shader.BindUniformBlocks();
+    shader.ready = true;
 
-    Shader::Library::compiled_shader_library[_name] = compiled_shader;
+    if (!_program.cache_key.empty())
+        Shader::Cache::Store(_program.cache_key, shader.program_id);
+}
+
+std::shared_ptr<Shader> Shader::Library::CreateCachedProgram(const std::vector<std::pair<std::string, GLenum>>& _stages, const std::string& _defines, const std::string& _variantName) {
+    std::string shader_name;
+    for (const auto &[path, type]: _stages)
+        shader_name.append(shader_name.empty() ? "" : "-").append(path);
+
+    shader_name.append(_variantName);
+
+    if (Shader::Library::compiled_shader_library.contains(shader_name))
+        return Shader::Library::compiled_shader_library[shader_name];
+
+    //the defines are part of the sources, so every variant has its own cache key too
+    std::vector<std::string> sources;
+    for (const auto &[path, type]: _stages)
+        sources.push_back(Shader::Library::InjectDefines(Shader::Library::ReadShaderCode(path), _defines));
+
+    const std::string key = Shader::Cache::GetKey(sources);
+
+    //warm start, nothing to compile nor link, so the program is ready right away
+    if (const GLuint program_id = Shader::Cache::Load(key); program_id != 0) {
+        std::shared_ptr<Shader> compiled_shader = std::make_shared<Shader>(0, 0, program_id);
+        compiled_shader->ReflectUniforms();
+        compiled_shader->BindUniformBlocks();
+        compiled_shader->ready = true;
+        compiled_shader->stage_paths = _stages;
+
+        Shader::Library::compiled_shader_library[shader_name] = compiled_shader;
+
+        return compiled_shader;
+    }
+
+    uint32_t vertex_id = 0, geometry_id = 0, fragment_id = 0;
+
+    for (size_t i = 0; i < _stages.size(); ++i) {
+        const auto &[path, type] = _stages[i];
+        const uint32_t shader_id = Shader::Library::GetOrAddShader(path + _variantName, type, sources[i]);
+
+        if (type == GL_VERTEX_SHADER)
+            vertex_id = shader_id;
+        else if (type == GL_GEOMETRY_SHADER)
+            geometry_id = shader_id;
+        else
+            fragment_id = shader_id;
+    }
+
+    //cached once it's done
+    std::shared_ptr<Shader> compiled_shader = Shader::Library::AddProgram(shader_name, vertex_id, fragment_id, geometry_id, key);
+    compiled_shader->stage_paths = _stages;
 
     return compiled_shader;
 }
 
+uint32_t Shader::Library::GetOrAddShader(const std::string& _shaderPath, GLenum _type, const std::string& _code) {
+    if (Shader::Library::shader_library.contains(_shaderPath))
+        return Shader::Library::shader_library[_shaderPath];
+
+    return Shader::Library::AddShader(_shaderPath, _type, 1, _code.c_str());
+}
+
+std::string Shader::Library::InjectDefines(const std::string& _code, const std::string& _defines) {
+    if (_defines.empty())
+        return _code;
+
+    const size_t version = _code.find("#version");
+    const size_t version_end = version != std::string::npos ? _code.find('\n', version) : std::string::npos;
+
+    if (version_end == std::string::npos)
+        return _defines + _code;
+
+    //the following lines keep their numbers in the compile errors
+    const auto next_line = std::count(_code.begin(), _code.begin() + (long)version_end, '\n') + 2;
+
+    return _code.substr(0, version_end + 1) + _defines + "#line " + std::to_string(next_line) + "\n" + _code.substr(version_end + 1);
+}
+
 std::string Shader::Library::ReadShaderCode(const std::string& _shaderCodePath) {
     std::string shaderCodeString; //actual shader code
     std::ifstream shaderFile; //file handler
@@ -210,3 +461,111 @@ std::string Shader::Library::ReadShaderCode(const std::string& _shaderCodePath)
 
     return shaderCodeString;
 }
+
+std::string Shader::Cache::GetKey(const std::vector<std::string>& _sources) {
+    std::string key;
+
+    for (const GLenum name: { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+        const auto *value = (const char *)glGetString(name);
+        key.append(value != nullptr ? value : "").append("\n");
+    }
+
+    //the sources are only hashed, they'd make the key (stored in the file) as big as the binary
+    char source_hash[17];
+    for (const auto &source: _sources) {
+        std::snprintf(source_hash, sizeof(source_hash), "%016llx", (unsigned long long)Hash(source));
+        key.append(source_hash).append("\n");
+    }
+
+    return key;
+}
+
+GLuint Shader::Cache::Load(const std::string& _key) {
+    const MappedFile file(GetPath(_key));
+
+    if (!file.IsValid() || file.GetSize() < sizeof(Header))
+        return 0;
+
+    Header header;
+    std::memcpy(&header, file.GetData(), sizeof(Header));
+
+    //anything that doesn't match means the file is stale (or broken), and the program gets compiled from its sources again
+    if (std::memcmp(header.magic, "PROG", 4) != 0 || header.version != VERSION || header.key_hash != Hash(_key) || header.key_length != _key.size())
+        return 0;
+
+    if (sizeof(Header) + header.key_length + header.binary_size > file.GetSize() || std::memcmp(file.GetData() + sizeof(Header), _key.data(), _key.size()) != 0)
+        return 0;
+
+    const GLuint program_id = glCreateProgram();
+    glProgramBinary(program_id, header.binary_format, file.GetData() + sizeof(Header) + header.key_length, (GLsizei)header.binary_size);
+
+    //drivers can still reject a binary (e.g. after an update that kept the same strings)
+    int success;
+    glGetProgramiv(program_id, GL_LINK_STATUS, &success);
+
+    if (!success) {
+        glDeleteProgram(program_id);
+        return 0;
+    }
+
+    return program_id;
+}
+
+void Shader::Cache::Store(const std::string& _key, GLuint _programId) {
+    int success;
+    glGetProgramiv(_programId, GL_LINK_STATUS, &success);
+
+    GLint binary_length = 0;
+    glGetProgramiv(_programId, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+
+    //nothing to store if the program didn't link, or if the driver has no binary format
+    if (!success || binary_length <= 0)
+        return;
+
+    std::vector<char> binary(binary_length);
+    GLsizei written_length = 0;
+    GLenum binary_format = 0;
+    glGetProgramBinary(_programId, binary_length, &written_length, &binary_format, binary.data());
+
+    if (written_length <= 0)
+        return;
+
+    Header header = {};
+    std::memcpy(header.magic, "PROG", 4);
+    header.version = VERSION;
+    header.key_hash = Hash(_key);
+    header.key_length = (uint32_t)_key.size();
+    header.binary_format = binary_format;
+    header.binary_size = (uint64_t)written_length;
+
+    std::error_code error;
+    std::filesystem::create_directories(DIRECTORY, error);
+
+    std::ofstream file(GetPath(_key), std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cout << "ERROR::SHADER::PROGRAM::CACHE_NOT_WRITTEN -> " << GetPath(_key) << std::endl;
+        return;
+    }
+
+    file.write((const char *)&header, sizeof(Header));
+    file.write(_key.data(), (std::streamsize)_key.size());
+    file.write(binary.data(), written_length);
+}
+
+std::string Shader::Cache::GetPath(const std::string& _key) {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", (unsigned long long)Hash(_key));
+
+    return DIRECTORY + name + ".bin";
+}
+
+uint64_t Shader::Cache::Hash(const std::string& _key) {
+    uint64_t hash = 14695981039346656037ull;
+
+    for (char character: _key) {
+        hash ^= (uint8_t)character;
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
@@ -7,33 +7,139 @@
 #include <sstream>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include "glad/glad.h" // include glad to get all the required OpenGL headers
 #include "glm/vec2.hpp"
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/type_ptr.hpp"
-#include "Light.h"
 #include "Texture.h"
 
 class Shader {
 public:
+    // Handle to a uniform, identified by the hash of its name
+    // String literals are hashed at compile time, so looking up a uniform's location never touches its name at runtime
+    struct Uniform {
+        uint32_t hash;
+
+        consteval Uniform(const char *_name) : hash(Hash(_name)) {} // implicit, so that string literals can be passed directly
+
+        static Uniform FromString(std::string_view _name); // for names only known at runtime
+
+        static constexpr uint32_t Hash(std::string_view _name) {
+            // 32-bit FNV-1a
+            uint32_t hash = 2166136261u;
+
+            for (const char c: _name) {
+                hash ^= (uint8_t)c;
+                hash *= 16777619u;
+            }
+
+            return hash;
+        }
+
+    private:
+        constexpr explicit Uniform(uint32_t _hash, bool) : hash(_hash) {}
+    };
+
+    // Variant of a program, specialized on the features it was created with (see Library::CreateShader)
+    // Each feature becomes #defines injected after the #version line of every stage, which the shaders read with defaults for the general program (see lit.frag)
+    struct Permutation {
+        enum Feature : uint32_t {
+            LIGHTS = 1 << 0,  // LIGHT_COUNT & SPOT_LIGHT_MASK: only the used lights are looped over, their types known at compile time
+            SHADOWS = 1 << 1, // SHADOWS: 0 skips the shadow map lookups
+            TEXTURE = 1 << 2, // TEXTURE: 0 skips the texture sampling, for untextured materials
+        };
+
+        int light_count = 0;
+        uint32_t spot_light_mask = 0; // bit i is set if light i is a spotlight, it's a point light otherwise
+        bool shadows = false;
+        bool texture = false;
+
+        // only the given features count, so that permutations that don't differ for a program share their key & defines
+        [[nodiscard]] uint32_t GetKey(uint32_t _features) const;
+        [[nodiscard]] std::string GetDefines(uint32_t _features) const;
+    };
+
+    // Linked programs saved on disk with glGetProgramBinary, so that the next launches load them instead of compiling their sources again
+    // Binaries only work with the driver that made them, so the key has its vendor, renderer & version along with the hash of the sources
+    class Cache {
+    public:
+        inline static const std::string DIRECTORY = "cache/shaders/";
+
+        // files of another version are stale and get linked again, so it has to be bumped whenever the format changes
+        constexpr static uint32_t VERSION = 1;
+
+    private:
+        struct Header {
+            char magic[4]; // "PROG"
+            uint32_t version;
+            uint64_t key_hash;
+            uint32_t key_length; // the key itself follows the header, to tell apart keys with the same hash
+            uint32_t binary_format;
+            uint64_t binary_size; // the binary follows the key
+        };
+
+    public:
+        static std::string GetKey(const std::vector<std::string>& _sources); // needs a current GL context
+
+        // 0 if the key has no valid file, or if the driver rejects its binary
+        static GLuint Load(const std::string& _key);
+        static void Store(const std::string& _key, GLuint _programId);
+
+    private:
+        static std::string GetPath(const std::string& _key);
+        static uint64_t Hash(const std::string& _key); // FNV-1a
+    };
+
+    // Compiles & links without waiting: programs are only submitted to the driver, and become ready once a later PollPending() sees them done
+    // With GL_KHR_parallel_shader_compile the driver compiles them on its own threads, and their completion is polled without stalling
     class Library {
     private:
+        // A program submitted to the driver, whose status hasn't been asked for yet (asking waits for the compile & link)
+        struct PendingProgram {
+            std::string name;
+            std::shared_ptr<Shader> shader;
+            std::string cache_key;
+        };
+
         inline static std::unordered_map<std::string, uint32_t> shader_library;
         inline static std::unordered_map<std::string, std::shared_ptr<Shader>> compiled_shader_library;
 
+        inline static std::vector<PendingProgram> pending_programs;
+        inline static std::optional<bool> parallel_compile; // whether the driver can compile in the background, unknown until the first compile
+
     public:
         Library();
 
-        static std::shared_ptr<Shader> CreateShader(const std::string& _vertexShaderPath, const std::string& _fragmentShaderPath);
+        // the features are the ones the program's variants can be specialized on (see GetVariant), none if it's always drawn as it is
+        static std::shared_ptr<Shader> CreateShader(const std::string& _vertexShaderPath, const std::string& _fragmentShaderPath, uint32_t _permutationFeatures = 0);
+        static std::shared_ptr<Shader> CreateShader(const std::string& _vertexShaderPath, const std::string& _geometryShaderPath, const std::string& _fragmentShaderPath);
         static std::shared_ptr<Shader> CreateShader(uint32_t _vertexShaderId, uint32_t _fragmentShaderPath);
 
         static uint32_t AddShader(const std::string& _name, GLenum _type, GLsizei _count, const char* _code, const GLint* _length = nullptr);
-        static std::shared_ptr<Shader> AddProgram(const std::string& _name, uint32_t _vertexId, uint32_t _fragmentId);
+        static std::shared_ptr<Shader> AddProgram(const std::string& _name, uint32_t _vertexId, uint32_t _fragmentId, uint32_t _geometryId = 0);
+
+        static void PollPending(); // finishes the programs the driver is done with, has to be called on the GL thread, e.g. once per frame
+        static bool IsCompiling();
+
+        static std::shared_ptr<Shader> CreateVariant(const Shader& _shader, const Permutation& _permutation); // submitted like any other program
 
     private:
+        static bool IsParallelCompileSupported(); // also asks the driver for its compiler threads, the first time
+        static bool IsDone(const PendingProgram& _program);
+        static void Finish(const PendingProgram& _program); // reports the compile & link errors, then reflects & caches the program
+        // the program of the given stages (paths & types), loaded from the cache when it can be, and only compiled & linked (then cached) otherwise
+        // the defines are injected in every stage, the variant name telling apart the stages & programs of different variants
+        static std::shared_ptr<Shader> CreateCachedProgram(const std::vector<std::pair<std::string, GLenum>>& _stages, const std::string& _defines = "", const std::string& _variantName = "");
+
+        static std::shared_ptr<Shader> AddProgram(const std::string& _name, uint32_t _vertexId, uint32_t _fragmentId, uint32_t _geometryId, const std::string& _cacheKey); // cached once it's done, unless the key is empty
+
+        static uint32_t GetOrAddShader(const std::string& _shaderPath, GLenum _type, const std::string& _code); // compiles the shader at the given path, unless it already was
         static std::string ReadShaderCode(const std::string& shaderCodePath);
+        static std::string InjectDefines(const std::string& _code, const std::string& _defines); // right after the #version line, which has to come first
     };
 
     // Describes all of a shader's properties (regardless of whether they are used or not)
@@ -47,44 +153,69 @@ public:
         glm::vec3 color = glm::vec3(1.0f);
         float alpha = 1.0f;
 
-        std::shared_ptr<std::vector<Light>> lights = std::make_shared<std::vector<Light>>();
-
-        std::shared_ptr<Texture> texture = std::make_shared<Texture>(0, "", 0, 0, 0, 0);
+        std::shared_ptr<Texture> texture = std::make_shared<Texture>();
         float texture_influence = 0.0f;
         glm::vec2 texture_tiling = glm::vec2(1.0f);
 
         int shininess = 32;
+
+        std::vector<glm::vec3> color_palette; // colors picked by the vertices' material ids (baked meshes), color is used instead if empty
     };
 
+    // Binding points of the uniform & storage blocks shared by all programs
+    inline constexpr static GLuint LIGHTS_BLOCK_BINDING = 0;
+    inline constexpr static GLuint VIEW_BLOCK_BINDING = 1;
+    inline constexpr static GLuint OBJECT_BLOCK_BINDING = 2;
+
+    inline constexpr static int MAX_COLOR_PALETTE_SIZE = 8; // size of the color palette array in the shaders
+
 public:
     uint32_t program_id;
-    uint32_t vertex_shader_id;
+    uint32_t vertex_shader_id; // the stages are 0 if the program was loaded from the cache
     uint32_t fragment_shader_id;
+    uint32_t geometry_shader_id = 0; // optional, 0 if the program has no geometry stage
+
+private:
+    // Locations of all active uniforms, keyed by the hash of their name (filled once, at link time)
+    std::unordered_map<uint32_t, GLint> uniform_locations;
+
+    bool ready = false; // linked & reflected, objects using the program aren't drawn until then
+
+    // Stages of a program created from files, & the features its variants can be specialized on
+    std::vector<std::pair<std::string, GLenum>> stage_paths;
+    uint32_t permutation_features = 0;
+    std::unordered_map<uint32_t, std::shared_ptr<Shader>> variants; // compiled on demand, keyed by their permutation's key
 
 public:
     Shader(uint32_t _vertexShaderId, uint32_t _fragmentShaderId, uint32_t _programId);
 
     void Use() const; //activates the shader
+    [[nodiscard]] bool IsReady() const;
+
+    // the variant of the program for the permutation, itself if it has no features or while the variant is still compiling
+    [[nodiscard]] const Shader &GetVariant(const Permutation &_permutation);
+
+    void ReflectUniforms(); // queries & caches the locations of all active uniforms of the program
+    void BindUniformBlocks() const; // attaches the program's shared uniform & storage blocks to their binding points
+    [[nodiscard]] GLint GetUniformLocation(Uniform _uniform) const; // -1 if the uniform isn't active in this program
 
-    void SetBool(const char* _name, bool _value) const; // utility function to set a bool value
-    void SetInt(const char *_name, int _value) const;  // utility function to set a int _value
+    void SetBool(Uniform _uniform, bool _value) const; // utility function to set a bool value
+    void SetInt(Uniform _uniform, int _value) const;  // utility function to set a int _value
 
-    void SetFloat(const char *_name, float _value) const; // utility function to set a float _value
-    void SetFloatFast(const char *_name, float _value) const; // utility function to set a flow value on an active program
+    void SetFloat(Uniform _uniform, float _value) const; // utility function to set a float _value
+    void SetFloatFast(Uniform _uniform, float _value) const; // utility function to set a flow value on an active program
 
-    void SetVec2(const char *_name, float _valueX, float _valueY) const; // utility function to set a vector 2
-    void SetVec2(const char *_name, const glm::vec2& _value) const; // utility function to set a vector 2
+    void SetVec2(Uniform _uniform, float _valueX, float _valueY) const; // utility function to set a vector 2
+    void SetVec2(Uniform _uniform, const glm::vec2& _value) const; // utility function to set a vector 2
 
     // utility functions to set a vector 3
-    void SetVec3(const char *_name, float _valueX, float _valueY, float _valueZ) const;
-    void SetVec3(const char *_name, const glm::vec3& _value) const;
+    void SetVec3(Uniform _uniform, float _valueX, float _valueY, float _valueZ) const;
+    void SetVec3(Uniform _uniform, const glm::vec3& _value) const;
 
-    void SetMat4(const char *_name, const glm::mat4 &_value) const; // utility function to set a matrix 4x4
+    void SetVec3Array(Uniform _uniform, const std::vector<glm::vec3>& _values) const; // utility function to set an array of vector 3
 
-    void SetTexture(const char *_name, GLint _value) const; // utility function to set a texture
-    void SetModelMatrix(const glm::mat4& _transform) const; // utility function to set model matrix
-    void SetViewProjectionMatrix(const glm::mat4& _transform) const; // utility function to set projection matrix
+    void SetMat4(Uniform _uniform, const glm::mat4 &_value) const; // utility function to set a matrix 4x4
 
-    void ApplyLightsToShader(const std::shared_ptr<std::vector<Light>> _lights) const; // utility function to set light information
+    void SetTexture(Uniform _uniform, GLint _value) const; // utility function to set a texture
 };
 
@@ -0,0 +1,81 @@
+#include "StreamBuffer.h"
+
+#include <cstring>
+#include <iostream>
+
+StreamBuffer::StreamBuffer(GLenum _target, GLsizeiptr _frameSize) {
+    target = _target;
+
+    //writes have to start at offsets the buffer can be bound at
+    if (target == GL_UNIFORM_BUFFER)
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    else if (target == GL_SHADER_STORAGE_BUFFER)
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+    frame_size = (_frameSize + alignment - 1) / alignment * alignment;
+
+    //immutable storage, mapped once: persistent (stays mapped while the GPU reads it) & coherent (writes are visible without flushing)
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &buffer_o);
+    glBindBuffer(target, buffer_o);
+    glBufferStorage(target, frame_size * FRAME_COUNT, nullptr, flags);
+
+    mapped_data = (uint8_t *)glMapBufferRange(target, 0, frame_size * FRAME_COUNT, flags);
+    glBindBuffer(target, 0);
+
+    if (mapped_data == nullptr)
+        std::cerr << "Error::StreamBuffer -> Could not persistently map the buffer" << std::endl;
+}
+
+StreamBuffer::~StreamBuffer() {
+    for (auto &fence: fences) {
+        if (fence != nullptr)
+            glDeleteSync(fence);
+    }
+
+    glBindBuffer(target, buffer_o);
+    glUnmapBuffer(target);
+    glBindBuffer(target, 0);
+
+    glDeleteBuffers(1, &buffer_o);
+}
+
+void StreamBuffer::BeginFrame() {
+    frame = (frame + 1) % FRAME_COUNT;
+    frame_offset = 0;
+
+    GLsync &fence = fences[frame];
+
+    if (fence == nullptr)
+        return;
+
+    //the region was last used FRAME_COUNT frames ago, so the fence is almost always signaled already
+    GLenum wait_result = glClientWaitSync(fence, 0, 0);
+
+    while (wait_result == GL_TIMEOUT_EXPIRED)
+        wait_result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); //1ms
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void StreamBuffer::EndFrame() {
+    fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+GLintptr StreamBuffer::Write(const void *_data, GLsizeiptr _size) {
+    if (mapped_data == nullptr || frame_offset + _size > frame_size)
+        return -1;
+
+    const GLintptr offset = frame * frame_size + frame_offset;
+    std::memcpy(mapped_data + offset, _data, _size);
+
+    frame_offset += (_size + alignment - 1) / alignment * alignment;
+
+    return offset;
+}
+
+GLuint StreamBuffer::GetId() const {
+    return buffer_o;
+}
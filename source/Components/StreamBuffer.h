@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "glad/glad.h"
+
+// A persistently mapped buffer for data rewritten every frame, filled with plain memcpy (no driver call per write)
+// It's split into one region per frame in flight, so that the CPU never writes where the GPU may still be reading:
+// each region is fenced once its frame is submitted, and only reused once that fence is signaled
+class StreamBuffer {
+public:
+    inline constexpr static int FRAME_COUNT = 3; // triple buffered
+
+private:
+    GLuint buffer_o = 0;
+    GLenum target = 0;
+
+    GLsizeiptr frame_size = 0; // size of one region
+    GLint alignment = 1; // offsets of the writes are rounded up to this (e.g. the uniform buffer offset alignment)
+
+    uint8_t *mapped_data = nullptr; // start of the whole buffer, mapped for as long as the buffer exists
+
+    int frame = 0; // region being written
+    GLsizeiptr frame_offset = 0; // write head, relative to the region
+    std::array<GLsync, FRAME_COUNT> fences = {};
+
+public:
+    StreamBuffer(GLenum _target, GLsizeiptr _frameSize);
+    ~StreamBuffer();
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    void BeginFrame(); // moves to the next region, waiting for the GPU to be done with it (only ever blocks if the GPU is FRAME_COUNT frames behind)
+    void EndFrame(); // fences the region, after all the draws reading it were submitted
+
+    GLintptr Write(const void *_data, GLsizeiptr _size); // copies the data into the current region, returns its offset in the buffer (-1 if the region is full)
+
+    [[nodiscard]] GLuint GetId() const;
+};
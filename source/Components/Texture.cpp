@@ -1,6 +1,76 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
 #include "Texture.h"
 #include "stb_image.h"
+#include "Utility/Dds.hpp"
+#include "Utility/MappedFile.hpp"
+
+int Texture::Array::AllocateLayer(Texture::Array::Format _format) {
+    Block &block = blocks[(int)_format];
+
+    //full, the array at least doubles so that growing stays rare
+    if (block.layer_count == block.capacity)
+        Grow(_format, std::max(INITIAL_CAPACITY, block.capacity * 2));
+
+    return block.layer_count++;
+}
+
+GLuint Texture::Array::GetId(Texture::Array::Format _format) {
+    return blocks[(int)_format].texture_o;
+}
+
+GLenum Texture::Array::GetInternalFormat(Texture::Array::Format _format) {
+    switch (_format) {
+        case Format::Bc1:
+            return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case Format::Bc3:
+            return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case Format::Rgba8:
+        default:
+            return GL_RGBA8;
+    }
+}
+
+int Texture::Array::GetFirstLevel(int _width, int _height) {
+    int level = 0;
+
+    while (std::max(_width >> level, _height >> level) > LAYER_SIZE)
+        level++;
+
+    return level;
+}
+
+void Texture::Array::Grow(Texture::Array::Format _format, int _capacity) {
+    Block &block = blocks[(int)_format];
+
+    GLuint texture_o = 0;
+    glGenTextures(1, &texture_o);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture_o);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, LEVEL_COUNT, GetInternalFormat(_format), LAYER_SIZE, LAYER_SIZE, _capacity);
+
+    // minified through the mipmaps, the wrapping is done by the shaders (the edges of a layer aren't the edges of its texture)
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    //the layers are copied on the GPU, level by level, nothing goes back through the CPU
+    if (block.texture_o != 0) {
+        for (int level = 0; level < LEVEL_COUNT; ++level) {
+            const int size = std::max(1, LAYER_SIZE >> level);
+            glCopyImageSubData(block.texture_o, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, texture_o, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, size, size, block.layer_count);
+        }
+
+        glDeleteTextures(1, &block.texture_o);
+    }
+
+    block.texture_o = texture_o;
+    block.capacity = _capacity;
+}
 
 Texture::Library::Library() {
     Texture::Library::texture_library = std::unordered_map<std::string, std::shared_ptr<Texture>>();
@@ -8,71 +78,312 @@ Texture::Library::Library() {
 
 std::shared_ptr<Texture> Texture::Library::CreateTexture(const std::string &_fileLocation) {
     if (!Texture::Library::texture_library.contains(_fileLocation)) {
-        Texture::Library::texture_library[_fileLocation] = std::make_shared<Texture>(Texture::Library::LoadTexture(_fileLocation));
+        // no layer yet, so the material's color shows until the image is there
+        const auto texture = std::make_shared<Texture>(_fileLocation);
+        Texture::Library::texture_library[_fileLocation] = texture;
+
+        if (decoders == nullptr)
+            decoders = std::make_unique<ThreadPool>();
+
+        {
+            std::lock_guard lock(decoded_mutex);
+            pending_count++;
+        }
+
+        decoders->Enqueue([texture]() { Decode(texture); });
     }
 
     return Texture::Library::texture_library[_fileLocation];
 }
 
-Texture Texture::Library::LoadTexture(const std::string &_fileLocation) {
-    // create and bind textures
-    GLuint texture_id = 0;
-    glGenTextures(1, &texture_id);
+void Texture::Library::UploadDecoded() {
+    std::vector<DecodedImage> images;
 
-    if (!texture_id)
     {
-        std::cerr << "Error::Texture -> Could not generate texture id for file: " << _fileLocation << std::endl;
+        std::lock_guard lock(decoded_mutex);
+        images.swap(decoded_images);
     }
 
-    glBindTexture(GL_TEXTURE_2D, texture_id);
+    size_t uploaded_size = 0;
 
-    // set filter & wrap parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    for (size_t i = 0; i < images.size(); ++i) {
+        // over budget, the rest waits for the next frame
+        if (uploaded_size >= UPLOAD_BUDGET) {
+            std::lock_guard lock(decoded_mutex);
+            decoded_images.insert(decoded_images.begin(), images.begin() + (long)i, images.end());
+            break;
+        }
 
-    // load texture with dimension data
-    int width, height, channels;
-    unsigned char *data = stbi_load(_fileLocation.c_str(), &width, &height, &channels, 0);
-    if (!data)
-    {
-        std::cerr << "Error::Texture -> Could not load texture file: " << _fileLocation << std::endl;
+        if (images[i].cooked_file != nullptr)
+            uploaded_size += UploadCooked(images[i]);
+        else
+            uploaded_size += Upload(images[i]);
+
+        std::lock_guard lock(decoded_mutex);
+        pending_count--;
+    }
+}
+
+bool Texture::Library::IsLoading() {
+    std::lock_guard lock(decoded_mutex);
+    return pending_count > 0;
+}
+
+void Texture::Library::Decode(const std::shared_ptr<Texture> &_texture) {
+    DecodedImage image = { .texture = _texture };
+
+    if (!LoadCooked(image)) {
+        // load texture with dimension data, as RGBA whatever the file has, like the cooked textures
+        Mipmaps::Level level;
+        uint8_t *data = stbi_load(_texture->file_location.c_str(), &level.width, &level.height, &image.channels, 4);
+
+        if (!data)
+        {
+            std::cerr << "Error::Texture -> Could not load texture file: " << _texture->file_location << std::endl;
+        }
+        else
+        {
+            level.pixels.assign(data, data + (size_t)level.width * level.height * 4);
+            stbi_image_free(data);
+
+            image.valid = true;
+            image.format = Array::Format::Rgba8;
+            image.width = level.width;
+            image.height = level.height;
+            image.first_level = Array::GetFirstLevel(level.width, level.height);
+
+            // not cooked, so the mipmaps are built here, the ones too big for a layer only to get to the next ones
+            for (int skipped = 0; skipped < image.first_level; ++skipped)
+                level = Mipmaps::Downsample(level);
+
+            const int level_count = Mipmaps::GetLevelCount(level.width, level.height);
+
+            for (int i = 0; i < level_count; ++i) {
+                image.levels.push_back(level);
+
+                if (i + 1 < level_count)
+                    level = Mipmaps::Downsample(level);
+            }
+        }
+    }
+
+    std::lock_guard lock(decoded_mutex);
+    decoded_images.push_back(std::move(image));
+}
+
+bool Texture::Library::LoadCooked(Texture::Library::DecodedImage &_image) {
+    const std::filesystem::path source_path = _image.texture->file_location;
+    const std::filesystem::path cooked_path = COOKED_DIRECTORY + source_path.stem().string() + ".dds";
+
+    // a cooked file older than its source is stale, the source is decoded instead until it's cooked again
+    std::error_code error;
+    if (!std::filesystem::exists(cooked_path, error))
+        return false;
+
+    if (std::filesystem::exists(source_path, error) && std::filesystem::last_write_time(cooked_path, error) < std::filesystem::last_write_time(source_path, error))
+        return false;
+
+    auto file = std::make_shared<const MappedFile>(cooked_path.string());
+    if (!file->IsValid() || file->GetSize() < sizeof(uint32_t) + sizeof(Dds::Header))
+        return false;
+
+    uint32_t magic;
+    Dds::Header header;
+    std::memcpy(&magic, file->GetData(), sizeof(uint32_t));
+    std::memcpy(&header, file->GetData() + sizeof(uint32_t), sizeof(Dds::Header));
+
+    if (magic != Dds::MAGIC || header.size != sizeof(Dds::Header) || (header.pixel_format.four_cc != Dds::DXT1 && header.pixel_format.four_cc != Dds::DXT5))
+        return false;
+
+    // every level has to be there, at least down to one that fits in a layer
+    const int mipmap_count = std::max(1, (int)header.mipmap_count);
+    const int first_level = Array::GetFirstLevel((int)header.width, (int)header.height);
+    size_t levels_size = 0;
+
+    if (first_level >= mipmap_count)
+        return false;
+
+    for (int level = 0; level < mipmap_count; ++level)
+        levels_size += Dds::GetLevelSize(std::max(1, (int)header.width >> level), std::max(1, (int)header.height >> level), header.pixel_format.four_cc);
+
+    if (sizeof(uint32_t) + sizeof(Dds::Header) + levels_size > file->GetSize())
+        return false;
+
+    _image.valid = true;
+    _image.format = header.pixel_format.four_cc == Dds::DXT5 ? Array::Format::Bc3 : Array::Format::Bc1;
+    _image.width = (int)header.width;
+    _image.height = (int)header.height;
+    _image.channels = header.pixel_format.four_cc == Dds::DXT5 ? 4 : 3;
+    _image.first_level = first_level;
+    _image.mipmap_count = mipmap_count;
+    _image.cooked_file = std::move(file);
+
+    return true;
+}
+
+bool Texture::Library::FillUploadBuffer(const std::vector<std::span<const uint8_t>> &_parts) {
+    size_t size = 0;
+    for (const auto &part : _parts)
+        size += part.size();
+
+    // the pixels are copied into a freshly orphaned pixel buffer, which the driver can then transfer to the texture without stalling on it
+    if (upload_buffer_o == 0)
+        glGenBuffers(1, &upload_buffer_o);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload_buffer_o);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)size, nullptr, GL_STREAM_DRAW);
+
+    auto *mapped_data = (uint8_t *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped_data == nullptr)
+        return false;
+
+    for (const auto &part : _parts) {
+        std::memcpy(mapped_data, part.data(), part.size());
+        mapped_data += part.size();
+    }
+
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    return true;
+}
+
+size_t Texture::Library::UploadCooked(const Texture::Library::DecodedImage &_image) {
+    Texture &texture = *_image.texture;
+
+    const uint32_t four_cc = _image.format == Array::Format::Bc3 ? Dds::DXT5 : Dds::DXT1;
+    const int level_count = std::min(_image.mipmap_count - _image.first_level, Array::LEVEL_COUNT);
+
+    // only the levels that fit in a layer are uploaded
+    size_t data_offset = sizeof(uint32_t) + sizeof(Dds::Header);
+    for (int level = 0; level < _image.first_level; ++level)
+        data_offset += Dds::GetLevelSize(std::max(1, _image.width >> level), std::max(1, _image.height >> level), four_cc);
+
+    size_t data_size = 0;
+    for (int level = _image.first_level; level < _image.first_level + level_count; ++level)
+        data_size += Dds::GetLevelSize(std::max(1, _image.width >> level), std::max(1, _image.height >> level), four_cc);
+
+    if (!FillUploadBuffer({ std::span(_image.cooked_file->GetData() + data_offset, data_size) })) {
+        std::cerr << "Error::Texture -> Could not map the upload buffer for file: " << texture.file_location << std::endl;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return 0;
+    }
+
+    const int layer = Array::AllocateLayer(_image.format);
+    const GLenum internal_format = Array::GetInternalFormat(_image.format);
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, Array::GetId(_image.format));
+
+    // every level is uploaded as it is, in the corner of the layer, the data pointers being offsets into the pixel buffer
+    size_t level_offset = 0;
+
+    for (int i = 0; i < level_count; ++i) {
+        const int width = std::max(1, _image.width >> (_image.first_level + i));
+        const int height = std::max(1, _image.height >> (_image.first_level + i));
+        const size_t level_size = Dds::GetLevelSize(width, height, four_cc);
+
+        //whole blocks, the ones over the texture's edges repeating its last pixels, unless the layer's level is smaller than a block
+        const int layer_size = std::max(1, Array::LAYER_SIZE >> i);
+        const int block_width = std::min((width + 3) / 4 * 4, layer_size);
+        const int block_height = std::min((height + 3) / 4 * 4, layer_size);
+
+        glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, layer, block_width, block_height, 1, internal_format, (GLsizei)level_size, (const GLvoid *)level_offset);
+        level_offset += level_size;
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    texture.width = _image.width;
+    texture.height = _image.height;
+    texture.channels = _image.channels;
+    texture.format = _image.format;
+    texture.layer = layer;
+    texture.uv_scale = glm::vec2(std::max(1, _image.width >> _image.first_level), std::max(1, _image.height >> _image.first_level)) / (float)Array::LAYER_SIZE;
+    texture.max_lod = (float)(level_count - 1);
+
+    return data_size;
+}
+
+size_t Texture::Library::Upload(const Texture::Library::DecodedImage &_image) {
+    Texture &texture = *_image.texture;
+
+    // a file that couldn't be decoded keeps its placeholder
+    if (!_image.valid)
+        return 0;
+
+    const int level_count = std::min((int)_image.levels.size(), Array::LEVEL_COUNT);
+
+    std::vector<std::span<const uint8_t>> parts;
+    size_t data_size = 0;
+
+    for (int i = 0; i < level_count; ++i) {
+        parts.emplace_back(_image.levels[i].pixels);
+        data_size += _image.levels[i].pixels.size();
+    }
+
+    if (!FillUploadBuffer(parts)) {
+        std::cerr << "Error::Texture -> Could not map the upload buffer for file: " << texture.file_location << std::endl;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return 0;
     }
 
-    // upload the texture to the GPU
-    GLenum format = 0;
-    if (channels == 1)
-        format = GL_RED;
-    else if (channels == 3)
-        format = GL_RGB;
-    else if (channels == 4)
-        format = GL_RGBA;
+    const int layer = Array::AllocateLayer(_image.format);
+
+    // upload the levels to the GPU, in the corner of the layer, from the pixel buffer (the data pointers being offsets into it)
+    glBindTexture(GL_TEXTURE_2D_ARRAY, Array::GetId(_image.format));
+
+    size_t level_offset = 0;
+
+    for (int i = 0; i < level_count; ++i) {
+        const Mipmaps::Level &level = _image.levels[i];
 
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height,
-                 0, format, GL_UNSIGNED_BYTE, data);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, layer, level.width, level.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, (const GLvoid *)level_offset);
+        level_offset += level.pixels.size();
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
-    // free resources
-    stbi_image_free(data);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    texture.width = _image.width;
+    texture.height = _image.height;
+    texture.channels = _image.channels;
+    texture.format = _image.format;
+    texture.layer = layer;
+    texture.uv_scale = glm::vec2(_image.levels[0].width, _image.levels[0].height) / (float)Array::LAYER_SIZE;
+    texture.max_lod = (float)(level_count - 1);
 
-    return Texture(texture_id, _fileLocation, width, height, 8, channels);
+    return data_size;
 }
 
-Texture::Texture(GLuint _textureId, const std::string& _fileLocation, int _width, int _height, int _bitDepth, int _channels) {
-    texture_id = _textureId;
+Texture::Texture(const std::string& _fileLocation) {
     file_location = _fileLocation;
-    width = _width;
-    height = _height;
-    bit_depth = _bitDepth;
-    channels = _channels;
+}
+
+GLuint Texture::GetId() const {
+    return format ? Array::GetId(*format) : 0;
+}
+
+bool Texture::IsLoaded() const {
+    return format.has_value();
+}
+
+int Texture::GetLayer() const {
+    return layer;
+}
+
+glm::vec2 Texture::GetUvScale() const {
+    return uv_scale;
+}
+
+float Texture::GetMaxLod() const {
+    return max_lod;
 }
 
 void Texture::Use(const unsigned int _textureUnit) const {
     glActiveTexture(_textureUnit);
-    glBindTexture(GL_TEXTURE_2D, texture_id);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, GetId());
 }
 
 void Texture::Clear() {
-    glBindTexture(GL_TEXTURE_2D, 0);
-}
\ No newline at end of file
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
@@ -1,33 +1,135 @@
 #pragma once
 
+#include <array>
 #include <unordered_map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
 #include "glad/glad.h"
+#include "glm/vec2.hpp"
+#include "Utility/Mipmaps.hpp"
+#include "Utility/ThreadPool.hpp"
+
+class MappedFile;
 
 class Texture {
 public:
+    // Packs every texture of the same format in the layers of one GL_TEXTURE_2D_ARRAY, so that objects with different textures can be drawn together
+    // Each texture sits in the corner of its layer (scaled by its uv scale), shaders wrap its uvs themselves & clamp its mip level (see lit.frag)
+    class Array {
+    public:
+        enum class Format {
+            Bc1,    // cooked, opaque
+            Bc3,    // cooked, with alpha
+            Rgba8,  // decoded at runtime, when there's no cooked file
+        };
+
+        constexpr static int FORMAT_COUNT = 3;
+
+        constexpr static int LAYER_SIZE = 1024; // bigger textures skip their first mip levels
+        constexpr static int LEVEL_COUNT = 11; // down to 1x1
+
+    private:
+        // One array texture & how many of its layers are used
+        // only used for static members, which start zeroed (i.e. no texture yet)
+        struct Block {
+            GLuint texture_o;
+            int capacity;
+            int layer_count;
+        };
+
+        constexpr static int INITIAL_CAPACITY = 4;
+
+        inline static std::array<Block, FORMAT_COUNT> blocks;
+
+    public:
+        static int AllocateLayer(Format _format); // the array grows if it's full, which changes its id
+        [[nodiscard]] static GLuint GetId(Format _format);
+        [[nodiscard]] static GLenum GetInternalFormat(Format _format);
+        [[nodiscard]] static int GetFirstLevel(int _width, int _height); // first mip level of an image that fits in a layer
+
+    private:
+        static void Grow(Format _format, int _capacity); // moves the layers to a bigger array
+    };
+
     class Library {
     private:
+        // An image decoded by a worker, waiting for the GL thread to upload it
+        struct DecodedImage {
+            std::shared_ptr<Texture> texture;
+            bool valid = false; // false if the file couldn't be decoded
+            Array::Format format = Array::Format::Rgba8;
+            int width = 0, height = 0, channels = 0; // of the whole image
+            int first_level = 0; // the levels before it don't fit in a layer
+
+            // cooked file, if there's an up to date one: its levels (from the first one) are uploaded as they are
+            std::shared_ptr<const MappedFile> cooked_file;
+            int mipmap_count = 0;
+
+            // otherwise, the levels of the decoded image (from the first one), built by the worker
+            std::vector<Mipmaps::Level> levels;
+        };
+
+    public:
+        // where the texture cooker puts the cooked textures (e.g. assets/sky.jpg -> cache/textures/sky.dds), mipmapped & block compressed
+        inline static const std::string COOKED_DIRECTORY = "cache/textures/";
+
+    private:
+        // uploads stop for the frame once this many bytes went through, so that a burst of decoded images doesn't stall a frame
+        constexpr static size_t UPLOAD_BUDGET = 16 * 1024 * 1024;
+
         inline static std::unordered_map<std::string, std::shared_ptr<Texture>> texture_library;
 
+        inline static std::mutex decoded_mutex;
+        inline static std::vector<DecodedImage> decoded_images;
+        inline static int pending_count = 0; // textures still waiting to be decoded or uploaded
+
+        inline static GLuint upload_buffer_o = 0; // pixel unpack buffer the images go through
+
+        // declared last, so that the workers are joined before anything they write to is destroyed
+        inline static std::unique_ptr<ThreadPool> decoders;
+
     public:
         Library();
 
+        // returns right away with a placeholder (white), the file is decoded in the background and uploaded by a later UploadDecoded()
         static std::shared_ptr<Texture> CreateTexture(const std::string& _fileLocation);
 
+        static void UploadDecoded(); // has to be called on the GL thread, e.g. once per frame
+        static bool IsLoading();
+
     private:
-        static Texture LoadTexture(const std::string &_fileLocation);
+        static void Decode(const std::shared_ptr<Texture> &_texture); // on a worker
+        static bool LoadCooked(DecodedImage &_image); // on a worker, false if there's no up to date cooked file
+        static size_t Upload(const DecodedImage &_image); // returns the uploaded size
+        static size_t UploadCooked(const DecodedImage &_image);
+        static bool FillUploadBuffer(const std::vector<std::span<const uint8_t>> &_parts); // binds the pixel unpack buffer, with the parts one after the other
     };
 
 private:
-    GLuint texture_id = 0;
     std::string file_location = "";
 
-    int width = 0, height = 0, bit_depth = 0, channels = 0;
+    int width = 0, height = 0, channels = 0;
+
+    // where the texture is in its array, no format until it's uploaded (the placeholder is drawn until then)
+    std::optional<Array::Format> format;
+    int layer = -1;
+    glm::vec2 uv_scale = glm::vec2(1.0f); // part of the layer covered by the texture
+    float max_lod = 0.0f; // last mip level the texture has in its layer
 
 public:
-    explicit Texture(GLuint _textureId, const std::string& _fileLocation, int _width, int _height, int _bitDepth, int _channels);
+    explicit Texture(const std::string& _fileLocation = "");
+
+    [[nodiscard]] GLuint GetId() const; // the id of the texture's array, shared with the other textures of its format (0 until it's uploaded)
+    [[nodiscard]] bool IsLoaded() const;
+
+    [[nodiscard]] int GetLayer() const; // -1 until it's uploaded
+    [[nodiscard]] glm::vec2 GetUvScale() const;
+    [[nodiscard]] float GetMaxLod() const;
 
-    void Use(unsigned int _textureUnit) const;
+    void Use(unsigned int _textureUnit) const; // binds the texture's whole array
     static void Clear();
 };
@@ -0,0 +1,38 @@
+#include "UniformBuffer.h"
+
+#include <cstring>
+
+UniformBuffer::UniformBuffer(GLuint _binding, GLsizeiptr _size) {
+    binding = _binding;
+    size = _size;
+
+    //generate the buffer & allocate its storage once, it's only ever updated afterwards
+    glGenBuffers(1, &buffer_o);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer_o);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    //attach the buffer to its binding point, where the programs' uniform blocks read from
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer_o);
+}
+
+bool UniformBuffer::Upload(const void *_data, GLsizeiptr _size) {
+    if ((GLsizeiptr)uploaded_data.size() == _size && std::memcmp(uploaded_data.data(), _data, _size) == 0)
+        return false;
+
+    uploaded_data.assign((const uint8_t *)_data, (const uint8_t *)_data + _size);
+
+    UploadAlways(_data, _size);
+
+    return true;
+}
+
+void UniformBuffer::UploadAlways(const void *_data, GLsizeiptr _size) {
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer_o);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, _size < size ? _size : size, _data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+GLuint UniformBuffer::GetBinding() const {
+    return binding;
+}
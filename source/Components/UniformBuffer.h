@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "glad/glad.h"
+
+// A uniform buffer object (UBO), bound to a fixed binding point that every program's matching uniform block reads from
+class UniformBuffer {
+private:
+    GLuint buffer_o = 0;
+    GLuint binding = 0;
+    GLsizeiptr size = 0;
+
+    // copy of the last uploaded content, to skip uploads when nothing changed
+    std::vector<uint8_t> uploaded_data;
+
+public:
+    UniformBuffer(GLuint _binding, GLsizeiptr _size);
+
+    bool Upload(const void *_data, GLsizeiptr _size); // uploads the data only if it's different from the last upload, returns whether it did
+    void UploadAlways(const void *_data, GLsizeiptr _size); // uploads the data, without comparing it to the last upload
+
+    [[nodiscard]] GLuint GetBinding() const;
+};
@@ -0,0 +1,487 @@
+#include "Mesh.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <utility>
+#include "Utility/MappedFile.hpp"
+
+Mesh::Library::Library() {
+    Mesh::Library::mesh_library = std::unordered_map<std::string, std::shared_ptr<Mesh>>();
+}
+
+std::shared_ptr<Mesh> Mesh::Library::CreateMesh(const std::string &_key, Mesh::Layout _layout, const std::function<void(std::vector<float>&, std::vector<int>&)> &_build) {
+    if (!Mesh::Library::mesh_library.contains(_key)) {
+        auto entry = Mesh::Cache::Load(_key);
+
+        if (entry.has_value() && entry->layout == _layout) {
+            Mesh::Library::mesh_library[_key] = std::make_shared<Mesh>(std::move(*entry));
+        } else {
+            std::vector<float> vertices;
+            std::vector<int> indices;
+            _build(vertices, indices);
+
+            Mesh::Library::mesh_library[_key] = std::make_shared<Mesh>(std::move(vertices), std::move(indices), _layout);
+            Mesh::Cache::Store(_key, *Mesh::Library::mesh_library[_key]);
+        }
+    }
+
+    return Mesh::Library::mesh_library[_key];
+}
+
+std::shared_ptr<Mesh> Mesh::Library::CreateMesh(const std::string &_key, const std::shared_ptr<const Mesh> &_vertexSource, const std::function<void(std::vector<int>&)> &_build) {
+    if (!Mesh::Library::mesh_library.contains(_key)) {
+        auto entry = Mesh::Cache::Load(_key);
+
+        //the indices have to fit in the source's vertices, which may have been regenerated since
+        const auto fits_source = [&_vertexSource](const Mesh::Cache::Entry &_entry) {
+            const int vertex_count = _vertexSource->GetVertexRange().count;
+            return std::all_of(_entry.indices.begin(), _entry.indices.end(), [vertex_count](int _index) { return _index >= 0 && _index < vertex_count; });
+        };
+
+        if (entry.has_value() && !entry->layout.has_value() && fits_source(*entry)) {
+            Mesh::Library::mesh_library[_key] = std::make_shared<Mesh>(std::move(*entry), _vertexSource);
+        } else {
+            std::vector<int> indices;
+            _build(indices);
+
+            Mesh::Library::mesh_library[_key] = std::make_shared<Mesh>(_vertexSource, std::move(indices));
+            Mesh::Cache::Store(_key, *Mesh::Library::mesh_library[_key]);
+        }
+    }
+
+    return Mesh::Library::mesh_library[_key];
+}
+
+std::optional<Mesh::Cache::Entry> Mesh::Cache::Load(const std::string &_key) {
+    auto file = std::make_shared<const MappedFile>(GetPath(_key));
+
+    if (!file->IsValid() || file->GetSize() < sizeof(Header))
+        return std::nullopt;
+
+    Header header;
+    std::memcpy(&header, file->GetData(), sizeof(Header));
+
+    //anything that doesn't match means the file is stale (or broken), and the mesh gets generated again
+    if (std::memcmp(header.magic, "MESH", 4) != 0 || header.version != VERSION || header.key_hash != Hash(_key) || header.key_length != _key.size())
+        return std::nullopt;
+
+    if (sizeof(Header) + header.key_length > file->GetSize() || std::memcmp(file->GetData() + sizeof(Header), _key.data(), _key.size()) != 0)
+        return std::nullopt;
+
+    if (header.layout < -1 || header.layout >= LAYOUT_COUNT || (header.layout >= 0 && (int)header.stride != Mesh::GetStride((Layout)header.layout)))
+        return std::nullopt;
+
+    const uint64_t vertices_size = (uint64_t)header.vertex_count * header.stride * sizeof(float);
+    const uint64_t indices_size = (uint64_t)header.index_count * sizeof(int);
+
+    if (header.vertices_offset % DATA_ALIGNMENT != 0 || header.indices_offset % DATA_ALIGNMENT != 0 ||
+        header.vertices_offset + vertices_size > file->GetSize() || header.indices_offset + indices_size > file->GetSize())
+        return std::nullopt;
+
+    Entry entry;
+    entry.layout = header.layout >= 0 ? std::optional<Layout>((Layout)header.layout) : std::nullopt;
+    entry.vertices = { (const float *)(file->GetData() + header.vertices_offset), (size_t)header.vertex_count * header.stride };
+    entry.indices = { (const int *)(file->GetData() + header.indices_offset), (size_t)header.index_count };
+    entry.bounds.min = glm::vec3(header.bounds_min[0], header.bounds_min[1], header.bounds_min[2]);
+    entry.bounds.max = glm::vec3(header.bounds_max[0], header.bounds_max[1], header.bounds_max[2]);
+    entry.bounds.center = glm::vec3(header.bounds_center[0], header.bounds_center[1], header.bounds_center[2]);
+    entry.bounds.radius = header.bounds_radius;
+    entry.file = std::move(file);
+
+    return entry;
+}
+
+void Mesh::Cache::Store(const std::string &_key, const Mesh &_mesh) {
+    const auto align = [](uint64_t _offset) { return (_offset + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT; };
+
+    //a mesh drawing another mesh's vertices only stores its indices
+    const bool owns_vertices = _mesh.vertex_source == nullptr;
+    const int stride = _mesh.GetStride();
+
+    Header header = {};
+    std::memcpy(header.magic, "MESH", 4);
+    header.version = VERSION;
+    header.key_hash = Hash(_key);
+    header.key_length = (uint32_t)_key.size();
+    header.layout = owns_vertices ? (int32_t)_mesh.layout : -1;
+    header.stride = (uint32_t)stride;
+    header.vertex_count = owns_vertices ? (uint32_t)(_mesh.vertices.size() / stride) : 0;
+    header.index_count = (uint32_t)_mesh.indices.size();
+
+    for (int i = 0; i < 3; ++i) {
+        header.bounds_min[i] = _mesh.bounds.min[i];
+        header.bounds_max[i] = _mesh.bounds.max[i];
+        header.bounds_center[i] = _mesh.bounds.center[i];
+    }
+
+    header.bounds_radius = _mesh.bounds.radius;
+    header.vertices_offset = align(sizeof(Header) + header.key_length);
+    header.indices_offset = align(header.vertices_offset + (uint64_t)header.vertex_count * stride * sizeof(float));
+
+    std::error_code error;
+    std::filesystem::create_directories(DIRECTORY, error);
+
+    std::ofstream file(GetPath(_key), std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Error::Mesh -> Could not write the cache file of: " << _key << std::endl;
+        return;
+    }
+
+    const auto pad_to = [&file](uint64_t _offset) {
+        while ((uint64_t)file.tellp() < _offset)
+            file.put(0);
+    };
+
+    file.write((const char *)&header, sizeof(Header));
+    file.write(_key.data(), (std::streamsize)_key.size());
+
+    pad_to(header.vertices_offset);
+    if (owns_vertices)
+        file.write((const char *)_mesh.vertices.data(), (std::streamsize)(header.vertex_count * stride * sizeof(float)));
+
+    pad_to(header.indices_offset);
+    file.write((const char *)_mesh.indices.data(), (std::streamsize)(_mesh.indices.size() * sizeof(int)));
+}
+
+std::string Mesh::Cache::GetPath(const std::string &_key) {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", (unsigned long long)Hash(_key));
+
+    return DIRECTORY + name + ".mesh";
+}
+
+uint64_t Mesh::Cache::Hash(const std::string &_key) {
+    uint64_t hash = 14695981039346656037ull;
+
+    for (char character: _key) {
+        hash ^= (uint8_t)character;
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+Mesh::Arena::Range Mesh::Arena::AllocateVertices(Mesh::Layout _layout, std::span<const float> _vertices) {
+    const int stride = Mesh::GetStride(_layout);
+    const int element_size = stride * (int)sizeof(float);
+
+    Block &block = vertex_blocks[(int)_layout];
+    const GLuint previous_buffer_o = block.buffer_o;
+    const Range range = Allocate(block, (int)_vertices.size() / stride, INITIAL_VERTEX_CAPACITY, element_size);
+
+    if (range.count == 0)
+        return range;
+
+    //the vertex array reads from the block's buffer, which may have been replaced by a bigger one
+    if (block.buffer_o != previous_buffer_o) {
+        GetVertexArray(_layout);
+        SetupVertexAttributes(_layout);
+    }
+
+    //uploaded through the copy target, so that the element buffer of whatever vertex array is bound stays untouched
+    glBindBuffer(GL_COPY_WRITE_BUFFER, block.buffer_o);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)range.offset * element_size, (GLsizeiptr)range.count * element_size, _vertices.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    return range;
+}
+
+Mesh::Arena::Range Mesh::Arena::AllocateIndices(std::span<const int> _indices) {
+    const GLuint previous_buffer_o = index_block.buffer_o;
+    const Range range = Allocate(index_block, (int)_indices.size(), INITIAL_INDEX_CAPACITY, sizeof(int));
+
+    if (range.count == 0)
+        return range;
+
+    //every vertex array draws from the same index buffer, so they all follow it when it's replaced by a bigger one
+    if (index_block.buffer_o != previous_buffer_o) {
+        for (GLuint vertex_array_o: vertex_arrays) {
+            if (vertex_array_o == 0)
+                continue;
+
+            glBindVertexArray(vertex_array_o);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_block.buffer_o);
+        }
+
+        glBindVertexArray(0);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, index_block.buffer_o);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)range.offset * (GLintptr)sizeof(int), (GLsizeiptr)range.count * (GLsizeiptr)sizeof(int), _indices.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    return range;
+}
+
+void Mesh::Arena::FreeVertices(Mesh::Layout _layout, const Mesh::Arena::Range &_range) {
+    Free(vertex_blocks[(int)_layout], _range);
+}
+
+void Mesh::Arena::FreeIndices(const Mesh::Arena::Range &_range) {
+    Free(index_block, _range);
+}
+
+GLuint Mesh::Arena::GetVertexArray(Mesh::Layout _layout) {
+    GLuint &vertex_array_o = vertex_arrays[(int)_layout];
+
+    if (vertex_array_o == 0) {
+        //the index buffer is shared by all vertex arrays, so it has to exist before the first one
+        if (index_block.buffer_o == 0)
+            Grow(index_block, INITIAL_INDEX_CAPACITY, sizeof(int));
+
+        glGenVertexArrays(1, &vertex_array_o);
+        glBindVertexArray(vertex_array_o);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_block.buffer_o);
+        glBindVertexArray(0);
+    }
+
+    return vertex_array_o;
+}
+
+Mesh::Arena::Range Mesh::Arena::Allocate(Mesh::Arena::Block &_block, int _count, int _initialCapacity, int _elementSize) {
+    if (_count == 0)
+        return {};
+
+    while (true) {
+        //first fit
+        for (auto free_range = _block.free_ranges.begin(); free_range != _block.free_ranges.end(); ++free_range) {
+            if (free_range->count < _count)
+                continue;
+
+            const Range range = { free_range->offset, _count };
+
+            free_range->offset += _count;
+            free_range->count -= _count;
+
+            if (free_range->count == 0)
+                _block.free_ranges.erase(free_range);
+
+            return range;
+        }
+
+        //nothing big enough, the buffer at least doubles so that growing stays rare
+        Grow(_block, std::max({ _initialCapacity, _block.capacity * 2, _block.capacity + _count }), _elementSize);
+    }
+}
+
+void Mesh::Arena::Free(Mesh::Arena::Block &_block, const Mesh::Arena::Range &_range) {
+    if (_range.count == 0)
+        return;
+
+    auto next = std::lower_bound(_block.free_ranges.begin(), _block.free_ranges.end(), _range, [](const Range &_a, const Range &_b) {
+        return _a.offset < _b.offset;
+    });
+
+    next = _block.free_ranges.insert(next, _range);
+
+    //merged with the following free range, then with the previous one, if they touch
+    if (next + 1 != _block.free_ranges.end() && next->offset + next->count == (next + 1)->offset) {
+        next->count += (next + 1)->count;
+        _block.free_ranges.erase(next + 1);
+    }
+
+    if (next != _block.free_ranges.begin() && (next - 1)->offset + (next - 1)->count == next->offset) {
+        (next - 1)->count += next->count;
+        _block.free_ranges.erase(next);
+    }
+}
+
+void Mesh::Arena::Grow(Mesh::Arena::Block &_block, int _capacity, int _elementSize) {
+    GLuint buffer_o = 0;
+    glGenBuffers(1, &buffer_o);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_o);
+    glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)_capacity * _elementSize, nullptr, GL_STATIC_DRAW);
+
+    //the content is copied on the GPU, nothing goes back through the CPU
+    if (_block.buffer_o != 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, _block.buffer_o);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, (GLsizeiptr)_block.capacity * _elementSize);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+        glDeleteBuffers(1, &_block.buffer_o);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    //the new space is free, merged with the last free range if it was at the end of the buffer
+    Free(_block, { _block.capacity, _capacity - _block.capacity });
+
+    _block.buffer_o = buffer_o;
+    _block.capacity = _capacity;
+}
+
+void Mesh::Arena::SetupVertexAttributes(Mesh::Layout _layout) {
+    const GLsizei stride = Mesh::GetStride(_layout) * (GLsizei)sizeof(float);
+
+    glBindVertexArray(vertex_arrays[(int)_layout]);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_blocks[(int)_layout].buffer_o);
+
+    //set vertex attributes pointers, every layout starts with the position
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid *) nullptr);
+    glEnableVertexAttribArray(0);
+
+    switch (_layout) {
+        case Layout::Positions:
+            break;
+        case Layout::PositionsUvs:
+            //uvs
+            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (GLvoid *) (3 * sizeof(float)));
+            glEnableVertexAttribArray(1);
+            break;
+        case Layout::PositionsNormals:
+        case Layout::PositionsNormalsUvs:
+        case Layout::PositionsNormalsUvsMaterials:
+            //normals
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid *) (3 * sizeof(float)));
+            glEnableVertexAttribArray(1);
+
+            if (_layout == Layout::PositionsNormals)
+                break;
+
+            //uvs
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (GLvoid *) (6 * sizeof(float)));
+            glEnableVertexAttribArray(2);
+
+            if (_layout == Layout::PositionsNormalsUvs)
+                break;
+
+            //material ids, after the 4 locations (3 to 6) of the per-instance model matrix
+            glVertexAttribPointer(7, 1, GL_FLOAT, GL_FALSE, stride, (GLvoid *) (8 * sizeof(float)));
+            glEnableVertexAttribArray(7);
+            break;
+    }
+
+    //cleanup buffers
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+Mesh::Mesh(std::vector<float> _vertices, std::vector<int> _indices, Mesh::Layout _layout) {
+    vertices = std::move(_vertices);
+    indices = std::move(_indices);
+    layout = _layout;
+
+    //bounding volumes, from the positions of the vertices
+    bounds = Bounds::FromVertices(vertices, GetStride());
+
+    vertex_range = Arena::AllocateVertices(layout, vertices);
+    index_range = Arena::AllocateIndices(indices);
+}
+
+Mesh::Mesh(std::shared_ptr<const Mesh> _vertexSource, std::vector<int> _indices) {
+    vertex_source = std::move(_vertexSource);
+    indices = std::move(_indices);
+    layout = vertex_source->layout;
+
+    //the indices may only use some of the vertices, but the bounds are only used for culling so the source's are close enough
+    bounds = vertex_source->bounds;
+
+    //only the indices are uploaded, they're relative to the source's first vertex just like the source's own indices
+    vertex_range = vertex_source->vertex_range;
+    index_range = Arena::AllocateIndices(indices);
+}
+
+Mesh::Mesh(Mesh::Cache::Entry _entry, std::shared_ptr<const Mesh> _vertexSource) {
+    cache_entry = std::move(_entry);
+    vertex_source = std::move(_vertexSource);
+
+    //nothing is computed or copied, the mapped geometry goes straight to the arena
+    if (vertex_source != nullptr) {
+        layout = vertex_source->layout;
+        bounds = vertex_source->bounds;
+        vertex_range = vertex_source->vertex_range;
+    } else {
+        layout = *cache_entry->layout;
+        bounds = cache_entry->bounds;
+        vertex_range = Arena::AllocateVertices(layout, cache_entry->vertices);
+    }
+
+    index_range = Arena::AllocateIndices(cache_entry->indices);
+}
+
+Mesh::~Mesh() {
+    //the vertices are freed by their source, which this mesh keeps alive
+    if (vertex_source == nullptr)
+        Arena::FreeVertices(layout, vertex_range);
+
+    Arena::FreeIndices(index_range);
+}
+
+const std::vector<float> &Mesh::GetVertices() const {
+    if (vertex_source != nullptr)
+        return vertex_source->GetVertices();
+
+    if (vertices.empty() && cache_entry.has_value())
+        vertices.assign(cache_entry->vertices.begin(), cache_entry->vertices.end());
+
+    return vertices;
+}
+
+const std::vector<int> &Mesh::GetIndices() const {
+    if (indices.empty() && cache_entry.has_value())
+        indices.assign(cache_entry->indices.begin(), cache_entry->indices.end());
+
+    return indices;
+}
+
+const Bounds &Mesh::GetBounds() const {
+    return bounds;
+}
+
+const Mesh::Arena::Range &Mesh::GetVertexRange() const {
+    return vertex_range;
+}
+
+const Mesh::Arena::Range &Mesh::GetIndexRange() const {
+    return index_range;
+}
+
+bool Mesh::IsIndexed() const {
+    return index_range.count > 0;
+}
+
+GLuint Mesh::GetVertexArray() const {
+    return Arena::GetVertexArray(layout);
+}
+
+int Mesh::GetStride() const {
+    return GetStride(layout);
+}
+
+int Mesh::GetStride(Mesh::Layout _layout) {
+    switch (_layout) {
+        case Layout::Positions:
+            return 3;
+        case Layout::PositionsUvs:
+            return 5;
+        case Layout::PositionsNormals:
+            return 6;
+        case Layout::PositionsNormalsUvs:
+            return 8;
+        case Layout::PositionsNormalsUvsMaterials:
+            return 9;
+    }
+
+    return 3;
+}
+
+void Mesh::Draw(int _renderMode, int _instanceCount) const {
+    //indices are relative to the mesh's first vertex, the base vertex moves them to where the mesh lives in the arena
+    if (IsIndexed()) {
+        const auto *first_index = (const GLvoid *)((size_t)index_range.offset * sizeof(int));
+
+        if (_instanceCount > 0)
+            glDrawElementsInstancedBaseVertex(_renderMode, index_range.count, GL_UNSIGNED_INT, first_index, _instanceCount, vertex_range.offset);
+        else
+            glDrawElementsBaseVertex(_renderMode, index_range.count, GL_UNSIGNED_INT, first_index, vertex_range.offset);
+    } else {
+        if (_instanceCount > 0)
+            glDrawArraysInstanced(_renderMode, vertex_range.offset, vertex_range.count, _instanceCount);
+        else
+            glDrawArrays(_renderMode, vertex_range.offset, vertex_range.count);
+    }
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "glad/glad.h"
+#include "Utility/Bounds.hpp"
+
+class MappedFile;
+
+// Geometry uploaded to the GPU, shared by every VisualObject that draws the same primitive
+class Mesh
+{
+public:
+    // How the vertex attributes are interleaved
+    enum class Layout {
+        Positions,                      // position (3)
+        PositionsUvs,                   // position (3) + uv (2)
+        PositionsNormals,               // position (3) + normal (3)
+        PositionsNormalsUvs,            // position (3) + normal (3) + uv (2)
+        PositionsNormalsUvsMaterials,   // position (3) + normal (3) + uv (2) + material id (1)
+    };
+
+    constexpr static int LAYOUT_COUNT = 5;
+
+    // Sub-allocates every mesh's geometry in a few big buffers: one vertex buffer per layout, and one index buffer shared by all layouts
+    // All meshes of a layout are drawn from the same vertex array, with offsets into the buffers (base vertex & first index)
+    class Arena {
+    public:
+        // Part of a buffer, in elements (vertices or indices)
+        struct Range {
+            int offset = 0;
+            int count = 0;
+        };
+
+    private:
+        // One buffer and its free parts, always sorted by offset & merged with their neighbours
+        // only used for static members, which start zeroed (i.e. no buffer yet)
+        struct Block {
+            GLuint buffer_o;
+            int capacity;
+            std::vector<Range> free_ranges;
+        };
+
+        constexpr static int INITIAL_VERTEX_CAPACITY = 1 << 16;
+        constexpr static int INITIAL_INDEX_CAPACITY = 1 << 18;
+
+        inline static std::array<Block, LAYOUT_COUNT> vertex_blocks;
+        inline static std::array<GLuint, LAYOUT_COUNT> vertex_arrays = {};
+        inline static Block index_block;
+
+    public:
+        static Range AllocateVertices(Layout _layout, std::span<const float> _vertices);
+        static Range AllocateIndices(std::span<const int> _indices);
+
+        // the freed ranges are reused by the next allocations
+        static void FreeVertices(Layout _layout, const Range& _range);
+        static void FreeIndices(const Range& _range);
+
+        static GLuint GetVertexArray(Layout _layout); // creates the layout's vertex array on first use
+
+    private:
+        static Range Allocate(Block& _block, int _count, int _initialCapacity, int _elementSize);
+        static void Free(Block& _block, const Range& _range);
+        static void Grow(Block& _block, int _capacity, int _elementSize); // moves the block's content to a bigger buffer
+
+        static void SetupVertexAttributes(Layout _layout); // points the layout's vertex array to its current vertex buffer
+    };
+
+    // Generated meshes saved on disk, so that the next launches map them & upload them as they are instead of generating them again
+    // One file per key: a header, then the interleaved vertices & the indices, each aligned so that they can be read in place
+    class Cache {
+    public:
+        // A cached mesh, pointing into its mapped file
+        struct Entry {
+            std::shared_ptr<const MappedFile> file;
+            std::optional<Layout> layout; // none for a mesh drawing the vertices of another mesh
+            std::span<const float> vertices;
+            std::span<const int> indices;
+            Bounds bounds;
+        };
+
+        inline static const std::string DIRECTORY = "cache/meshes/";
+
+        // files of another version are stale and get regenerated, so it has to be bumped whenever the format or a mesh generator changes
+        constexpr static uint32_t VERSION = 1;
+
+    private:
+        constexpr static size_t DATA_ALIGNMENT = 16; // of the vertices & the indices, from the start of the file (which is mapped page aligned)
+
+        struct Header {
+            char magic[4]; // "MESH"
+            uint32_t version;
+            uint64_t key_hash;
+            uint32_t key_length; // the key itself follows the header, to tell apart keys with the same hash
+            int32_t layout; // -1 for a mesh drawing the vertices of another mesh
+            uint32_t stride; // floats per vertex, checked against the layout
+            uint32_t vertex_count;
+            uint32_t index_count;
+            float bounds_min[3];
+            float bounds_max[3];
+            float bounds_center[3];
+            float bounds_radius;
+            uint64_t vertices_offset;
+            uint64_t indices_offset;
+        };
+
+    public:
+        // none if the key has no valid file
+        static std::optional<Entry> Load(const std::string& _key);
+        static void Store(const std::string& _key, const Mesh& _mesh);
+
+    private:
+        static std::string GetPath(const std::string& _key);
+        static uint64_t Hash(const std::string& _key); // FNV-1a
+    };
+
+    // Deduplicates primitives: all objects asking for the same key get the same mesh
+    // The meshes are loaded from the cache when they can be, and only built (then cached) otherwise
+    class Library {
+    private:
+        inline static std::unordered_map<std::string, std::shared_ptr<Mesh>> mesh_library;
+
+    public:
+        Library();
+
+        // the key has to describe everything the geometry depends on (e.g. "sphere radius=1 subdivisions=3"), the vertices & indices are only built the first time
+        static std::shared_ptr<Mesh> CreateMesh(const std::string& _key, Layout _layout, const std::function<void(std::vector<float>&, std::vector<int>&)>& _build);
+        // same, for a mesh that only has its own indices and draws the vertices of another mesh (e.g. a coarser level of detail)
+        static std::shared_ptr<Mesh> CreateMesh(const std::string& _key, const std::shared_ptr<const Mesh>& _vertexSource, const std::function<void(std::vector<int>&)>& _build);
+    };
+
+private:
+    // CPU copy of the geometry, e.g. to bake it into another mesh
+    // only copied out of the cache entry when it's first asked for, if the mesh was loaded from the cache
+    mutable std::vector<float> vertices;
+    mutable std::vector<int> indices; // drawn without indices if empty
+    std::optional<Cache::Entry> cache_entry;
+
+    // Mesh whose vertices are drawn with this mesh's indices, null if the mesh owns its vertices
+    std::shared_ptr<const Mesh> vertex_source;
+
+    Layout layout;
+    Bounds bounds;
+
+    // Where the geometry lives in the arena's buffers
+    Arena::Range vertex_range;
+    Arena::Range index_range;
+
+public:
+    Mesh(std::vector<float> _vertices, std::vector<int> _indices, Layout _layout);
+    Mesh(std::shared_ptr<const Mesh> _vertexSource, std::vector<int> _indices); // shares the source's vertices (and their arena range)
+    explicit Mesh(Cache::Entry _entry, std::shared_ptr<const Mesh> _vertexSource = nullptr); // uploaded straight from the mapped file, the source being needed if the entry has no vertices
+    ~Mesh();
+
+    // the arena ranges are owned by the mesh
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+
+    [[nodiscard]] const std::vector<float> &GetVertices() const;
+    [[nodiscard]] const std::vector<int> &GetIndices() const;
+    [[nodiscard]] const Bounds &GetBounds() const;
+    [[nodiscard]] const Arena::Range &GetVertexRange() const;
+    [[nodiscard]] const Arena::Range &GetIndexRange() const;
+    [[nodiscard]] bool IsIndexed() const;
+    [[nodiscard]] GLuint GetVertexArray() const; // shared by all meshes of the same layout
+    [[nodiscard]] int GetStride() const; // in floats
+
+    static int GetStride(Layout _layout);
+
+    // the vertex array has to be bound already
+    void Draw(int _renderMode, int _instanceCount = 0) const;
+};
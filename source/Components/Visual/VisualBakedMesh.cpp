@@ -0,0 +1,44 @@
+#include "VisualBakedMesh.h"
+
+#include <utility>
+#include "glm/mat3x3.hpp"
+
+VisualBakedMesh::VisualBakedMesh(const std::vector<Piece> &_pieces, Shader::Material _material) : VisualObject(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), std::move(_material))
+{
+    Bake(_pieces);
+}
+
+void VisualBakedMesh::Bake(const std::vector<Piece> &_pieces)
+{
+    std::vector<float> vertices;
+
+    for (const auto &piece: _pieces)
+    {
+        const auto &piece_vertices = piece.object->GetVertices();
+        const auto &piece_indices = piece.object->GetIndices();
+
+        //normals are transformed with the normal matrix, since the pieces are often scaled non-uniformly
+        const glm::mat3 normal_matrix = glm::transpose(glm::inverse(glm::mat3(piece.transform)));
+
+        //indexed pieces are expanded, since the baked mesh is drawn without indices
+        const size_t vertex_count = piece_indices.empty() ? piece_vertices.size() / 8 : piece_indices.size();
+
+        for (size_t i = 0; i < vertex_count; ++i)
+        {
+            const size_t v = (piece_indices.empty() ? i : (size_t)piece_indices[i]) * 8;
+
+            const glm::vec3 position = glm::vec3(piece.transform * glm::vec4(piece_vertices[v], piece_vertices[v + 1], piece_vertices[v + 2], 1.0f));
+            const glm::vec3 normal = glm::normalize(normal_matrix * glm::vec3(piece_vertices[v + 3], piece_vertices[v + 4], piece_vertices[v + 5]));
+
+            vertices.insert(vertices.end(), {
+                position.x, position.y, position.z,
+                normal.x, normal.y, normal.z,
+                piece_vertices[v + 6], piece_vertices[v + 7],
+                (float)piece.material_id,
+            });
+        }
+    }
+
+    //baked geometry is unique to this object, rebaking replaces (and releases) the previous mesh
+    SetMesh(std::make_shared<Mesh>(std::move(vertices), std::vector<int>(), Mesh::Layout::PositionsNormalsUvsMaterials));
+}
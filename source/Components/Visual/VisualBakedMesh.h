@@ -0,0 +1,27 @@
+// For information on how this class (and its parent class) work, see VisualObject.h
+
+#pragma once
+
+#include <vector>
+#include "glm/vec3.hpp"
+#include "glm/mat4x4.hpp"
+#include "Components/Shader.h"
+#include "VisualObject.h"
+
+// Geometry of many objects, pre-transformed & merged into a single vertex buffer at bake time, so that it's a single draw
+// Each vertex keeps the material id of its piece, which picks its color in the material's color palette
+class VisualBakedMesh : public VisualObject
+{
+public:
+    // One object to merge, with its transform relative to the baked mesh
+    struct Piece {
+        const VisualObject *object; // its vertices must be position + normal + uv
+        glm::mat4 transform;
+        int material_id;
+    };
+
+public:
+    explicit VisualBakedMesh(const std::vector<Piece> &_pieces, Shader::Material _material = Shader::Material());
+
+    void Bake(const std::vector<Piece> &_pieces); // (re)builds the whole mesh, e.g. when one of the pieces moved
+};
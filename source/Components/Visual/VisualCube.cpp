@@ -1,133 +1,155 @@
 #include "VisualCube.h"
 
-
+#include <string>
 #include <utility>
 #include "Utility/Transform.hpp"
 
 VisualCube::VisualCube(glm::vec3 _position, glm::vec3 _rotation, glm::vec3 _scale, glm::vec3 _transformOffset, Shader::Material _material) : VisualObject(_position, _rotation, _scale, std::move(_material))
 {
-    // vertices with their normals
-    vertices = {
-        // top face, top triangle
-        -0.5f, -0.5f, 0.5f,     0.0f, 0.0f, 1.0f,   0.0f, 0.0f,
-        0.5f, -0.5f, 0.5f,      0.0f, 0.0f, 1.0f,   1.0f, 0.0f,
-        0.5f, 0.5f, 0.5f,       0.0f, 0.0f, 1.0f,   1.0f, 1.0f,
-
-        // top face, bottom triangle
-        -0.5f, -0.5f, 0.5f,     0.0f, 0.0f, 1.0f,   0.0f, 0.0f,
-        0.5f, 0.5f, 0.5f,       0.0f, 0.0f, 1.0f,   1.0f, 1.0f,
-        -0.5f, 0.5f, 0.5f,      0.0f, 0.0f, 1.0f,   0.0f, 1.0f,
-
-        // right side, top triangle
-        0.5f, 0.5f, 0.5f,       1.0f, 0.0f, 0.0f,   0.0f, 0.0f,
-        0.5f, -0.5f, 0.5f,      1.0f, 0.0f, 0.0f,   1.0f, 0.0f,
-        0.5f, -0.5f, -0.5f,     1.0f, 0.0f, 0.0f,   1.0f, 1.0f,
-
-        // right side, bottom triangle
-        0.5f, 0.5f, 0.5f,       1.0f, 0.0f, 0.0f,   0.0f, 0.0f,
-        0.5f, -0.5f, -0.5f,     1.0f, 0.0f, 0.0f,   1.0f, 1.0f,
-        0.5f, 0.5f, -0.5f,      1.0f, 0.0f, 0.0f,   0.0f, 1.0f,
-
-        // front side, top triangle
-        -0.5f, 0.5f, 0.5f,      0.0f, 1.0f, 0.0f,   0.0f, 0.0f,
-        0.5f, 0.5f, 0.5f,       0.0f, 1.0f, 0.0f,   1.0f, 0.0f,
-        0.5f, 0.5f, -0.5f,      0.0f, 1.0f, 0.0f,   1.0f, 1.0f,
-
-        // front side, bottom triangle
-        -0.5f, 0.5f, 0.5f,      0.0f, 1.0f, 0.0f,   0.0f, 0.0f,
-        0.5f, 0.5f, -0.5f,      0.0f, 1.0f, 0.0f,   1.0f, 1.0f,
-        -0.5f, 0.5f, -0.5f,     0.0f, 1.0f, 0.0f,   0.0f, 1.0f,
-
-        // left side, top triangle
-        -0.5f, 0.5f, 0.5f,      -1.0f, 0.0f, 0.0f,  0.0f, 0.0f,
-        -0.5f, -0.5f, 0.5f,     -1.0f, 0.0f, 0.0f,  1.0f, 0.0f,
-        -0.5f, -0.5f, -0.5f,    -1.0f, 0.0f, 0.0f,  1.0f, 1.0f,
-
-        // left side, bottom triangle
-        -0.5f, 0.5f, 0.5f,      -1.0f, 0.0f, 0.0f,  0.0f, 0.0f,
-        -0.5f, -0.5f, -0.5f,    -1.0f, 0.0f, 0.0f,  1.0f, 1.0f,
-        -0.5f, 0.5f, -0.5f,     -1.0f, 0.0f, 0.0f,  0.0f, 1.0f,
-
-        // back side, top triangle
-        -0.5f, -0.5f, -0.5f,    0.0f, -1.0f, 0.0f,  0.0f, 0.0f,
-        0.5f, -0.5f, -0.5f,     0.0f, -1.0f, 0.0f,  1.0f, 0.0f,
-        0.5f, -0.5f, 0.5f,      0.0f, -1.0f, 0.0f,  1.0f, 1.0f,
-
-        // back side, bottom triangle
-        -0.5f, -0.5f, -0.5f,    0.0f, -1.0f, 0.0f,  0.0f, 0.0f,
-        0.5f, -0.5f, 0.5f,      0.0f, -1.0f, 0.0f,  1.0f, 1.0f,
-        -0.5f, -0.5f, 0.5f,     0.0f, -1.0f, 0.0f,  0.0f, 1.0f,
-
-        // bottom face, top triangle
-        -0.5f, -0.5f, -0.5f,    0.0f, 0.0f, -1.0f,  0.0f, 0.0f,
-        0.5f, -0.5f, -0.5f,     0.0f, 0.0f, -1.0f,  1.0f, 0.0f,
-        0.5f, 0.5f, -0.5f,      0.0f, 0.0f, -1.0f,  1.0f, 1.0f,
-
-        // bottom face, bottom triangle
-        -0.5f, -0.5f, -0.5f,    0.0f, 0.0f, -1.0f,  0.0f, 0.0f,
-        0.5f, 0.5f, -0.5f,      0.0f, 0.0f, -1.0f,  1.0f, 1.0f,
-        -0.5f, 0.5f, -0.5f,     0.0f, 0.0f, -1.0f,  0.0f, 1.0f,
-    };
-
-    for (int i = 0; i < vertices.size(); i += 8)
-    {
-        vertices[i] += _transformOffset.x;
-        vertices[i + 1] += _transformOffset.y;
-        vertices[i + 2] += _transformOffset.z;
-    }
+    // every cube with the same offset shares the same geometry
+    const std::string key = "cube offset=" + std::to_string(_transformOffset.x) + "," + std::to_string(_transformOffset.y) + "," + std::to_string(_transformOffset.z);
+
+    SetMesh(Mesh::Library::CreateMesh(key, Mesh::Layout::PositionsNormalsUvs, [&_transformOffset](std::vector<float> &_vertices, std::vector<int> &_indices) {
+        // vertices with their normals & uvs, 4 per face (faces don't share their vertices, since their normals differ)
+        _vertices = {
+            // top face
+            -0.5f, -0.5f, 0.5f,     0.0f, 0.0f, 1.0f,   0.0f, 0.0f,
+            0.5f, -0.5f, 0.5f,      0.0f, 0.0f, 1.0f,   1.0f, 0.0f,
+            0.5f, 0.5f, 0.5f,       0.0f, 0.0f, 1.0f,   1.0f, 1.0f,
+            -0.5f, 0.5f, 0.5f,      0.0f, 0.0f, 1.0f,   0.0f, 1.0f,
+
+            // right side
+            0.5f, 0.5f, 0.5f,       1.0f, 0.0f, 0.0f,   0.0f, 0.0f,
+            0.5f, -0.5f, 0.5f,      1.0f, 0.0f, 0.0f,   1.0f, 0.0f,
+            0.5f, -0.5f, -0.5f,     1.0f, 0.0f, 0.0f,   1.0f, 1.0f,
+            0.5f, 0.5f, -0.5f,      1.0f, 0.0f, 0.0f,   0.0f, 1.0f,
+
+            // front side
+            -0.5f, 0.5f, 0.5f,      0.0f, 1.0f, 0.0f,   0.0f, 0.0f,
+            0.5f, 0.5f, 0.5f,       0.0f, 1.0f, 0.0f,   1.0f, 0.0f,
+            0.5f, 0.5f, -0.5f,      0.0f, 1.0f, 0.0f,   1.0f, 1.0f,
+            -0.5f, 0.5f, -0.5f,     0.0f, 1.0f, 0.0f,   0.0f, 1.0f,
+
+            // left side
+            -0.5f, 0.5f, 0.5f,      -1.0f, 0.0f, 0.0f,  0.0f, 0.0f,
+            -0.5f, -0.5f, 0.5f,     -1.0f, 0.0f, 0.0f,  1.0f, 0.0f,
+            -0.5f, -0.5f, -0.5f,    -1.0f, 0.0f, 0.0f,  1.0f, 1.0f,
+            -0.5f, 0.5f, -0.5f,     -1.0f, 0.0f, 0.0f,  0.0f, 1.0f,
+
+            // back side
+            -0.5f, -0.5f, -0.5f,    0.0f, -1.0f, 0.0f,  0.0f, 0.0f,
+            0.5f, -0.5f, -0.5f,     0.0f, -1.0f, 0.0f,  1.0f, 0.0f,
+            0.5f, -0.5f, 0.5f,      0.0f, -1.0f, 0.0f,  1.0f, 1.0f,
+            -0.5f, -0.5f, 0.5f,     0.0f, -1.0f, 0.0f,  0.0f, 1.0f,
+
+            // bottom face
+            -0.5f, -0.5f, -0.5f,    0.0f, 0.0f, -1.0f,  0.0f, 0.0f,
+            0.5f, -0.5f, -0.5f,     0.0f, 0.0f, -1.0f,  1.0f, 0.0f,
+            0.5f, 0.5f, -0.5f,      0.0f, 0.0f, -1.0f,  1.0f, 1.0f,
+            -0.5f, 0.5f, -0.5f,     0.0f, 0.0f, -1.0f,  0.0f, 1.0f,
+        };
+
+        // 2 triangles per face
+        for (int face = 0; face < 6; ++face)
+        {
+            const int first_index = face * 4;
+            _indices.insert(_indices.end(), { first_index, first_index + 1, first_index + 2, first_index, first_index + 2, first_index + 3 });
+        }
+
+        for (int i = 0; i < _vertices.size(); i += 8)
+        {
+            _vertices[i] += _transformOffset.x;
+            _vertices[i + 1] += _transformOffset.y;
+            _vertices[i + 2] += _transformOffset.z;
+        }
+    }));
+}
 
-    VisualObject::SetupGlBuffersVerticesNormalsUvs();
+VisualCube::~VisualCube()
+{
+    if (instance_buffer_o != 0)
+        glDeleteBuffers(1, &instance_buffer_o);
 }
 
-void VisualCube::Draw(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, int _renderMode, const Shader::Material *material)
+VisualCube::VisualCube(VisualCube &&_other) : VisualObject(_other)
 {
-    glm::mat4 model_matrix = glm::mat4(1.0f);
-    model_matrix = glm::translate(model_matrix, position);
-    model_matrix = Transforms::RotateDegrees(model_matrix, rotation);
-    model_matrix = glm::scale(model_matrix, scale);
+    instance_buffer_o = std::exchange(_other.instance_buffer_o, 0);
+    instance_count = std::exchange(_other.instance_count, 0);
+}
 
-    DrawFromMatrix(_viewProjection, _cameraPosition, model_matrix, _renderMode, material);
+VisualCube &VisualCube::operator=(VisualCube &&_other)
+{
+    if (this == &_other)
+        return *this;
+
+    //the buffer this cube had is replaced by the other cube's
+    if (instance_buffer_o != 0)
+        glDeleteBuffers(1, &instance_buffer_o);
+
+    VisualObject::operator=(_other);
+    instance_buffer_o = std::exchange(_other.instance_buffer_o, 0);
+    instance_count = std::exchange(_other.instance_count, 0);
+
+    return *this;
 }
 
-void VisualCube::DrawFromMatrix(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material *_material)
+void VisualCube::SetInstances(const std::vector<glm::mat4> &_instanceTransforms)
 {
-    // bind the vertex array to draw
-    glBindVertexArray(vertex_array_o);
+    instance_count = (int)_instanceTransforms.size();
+
+    //the bounds become the union of all instances' bounds
+    const Bounds &mesh_bounds = mesh->GetBounds();
 
-    const Shader::Material *current_material = &material;
+    if (!_instanceTransforms.empty()) {
+        bounds = mesh_bounds.Transformed(_instanceTransforms.front());
 
-    // set the material to use on this frame
-    if (_material != nullptr)
-        current_material = _material;
+        for (const auto &instance_transform: _instanceTransforms)
+            bounds = bounds.Merged(mesh_bounds.Transformed(instance_transform));
+    } else {
+        bounds = mesh_bounds;
+    }
 
-    current_material->shader->Use();
-    current_material->shader->SetModelMatrix(_transformMatrix);
-    current_material->shader->SetViewProjectionMatrix(_viewProjection);
+    //generate the instance buffer only once, later calls simply replace its content
+    if (instance_buffer_o == 0)
+        glGenBuffers(1, &instance_buffer_o);
 
-    // camera properties
-    current_material->shader->SetVec3("u_cam_pos", _cameraPosition);
+    glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_o);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(_instanceTransforms.size() * sizeof(glm::mat4)),
+                 _instanceTransforms.empty() ? nullptr : &_instanceTransforms.front(), GL_STATIC_DRAW);
 
-    // lights
-    current_material->shader->ApplyLightsToShader(current_material->lights);
+    //cleanup buffers
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-    // material properties
-    current_material->shader->SetVec3("u_color", current_material->color);
-    current_material->shader->SetFloat("u_alpha", current_material->alpha);
-    current_material->shader->SetInt("u_shininess", current_material->shininess);
+int VisualCube::GetInstanceCount() const
+{
+    return instance_count;
+}
 
-    // texture mapping & consumption
-    current_material->texture->Use(GL_TEXTURE1);
-    current_material->shader->SetFloatFast("u_texture_influence", current_material->texture_influence);
-    current_material->shader->SetTexture("u_texture", 1);
-    current_material->shader->SetVec2("u_texture_tiling", current_material->texture_tiling);
+void VisualCube::DrawGeometry(int _renderMode, int _instanceCount) const
+{
+    if (_instanceCount == 0)
+    {
+        mesh->Draw(_renderMode);
+        return;
+    }
+
+    //the vertex array is shared with every other cube, so this cube's instance buffer is only attached to it for this draw
+    glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_o);
+
+    //a mat4 attribute takes 4 consecutive locations (one per column), starting after position, normal & uv
+    for (int i = 0; i < 4; ++i)
+    {
+        glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (GLvoid *) (i * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(3 + i);
+        glVertexAttribDivisor(3 + i, 1); //advance once per instance, instead of once per vertex
+    }
 
-    // line & point properties
-    glLineWidth(current_material->line_thickness);
-    glPointSize(current_material->point_size);
+    mesh->Draw(_renderMode, _instanceCount);
 
-    // draw vertices according to their indices
-    glDrawArrays(_renderMode, 0, vertices.size());
+    //detached, so that the next non-instanced draws of the shared vertex array don't read it
+    for (int i = 0; i < 4; ++i)
+        glDisableVertexAttribArray(3 + i);
 
-    // clear the current texture
-    current_material->texture->Clear();
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
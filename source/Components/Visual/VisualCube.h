@@ -10,9 +10,23 @@
 
 class VisualCube : public VisualObject
 {
+private:
+    // Per-instance model matrices, used by instanced draws
+    GLuint instance_buffer_o = 0;
+    int instance_count = 0;
+
 public:
     explicit VisualCube(glm::vec3 _position = glm::vec3(0.0f), glm::vec3 _rotation = glm::vec3(0.0f), glm::vec3 _scale = glm::vec3(1.0f), glm::vec3 _transformOffset = glm::vec3(0.0f), Shader::Material _material = Shader::Material());
+    ~VisualCube() override;
+
+    // the instance buffer has a single owner, it's handed over when the cube is moved
+    VisualCube(const VisualCube&) = delete;
+    VisualCube& operator=(const VisualCube&) = delete;
+    VisualCube(VisualCube&& _other);
+    VisualCube& operator=(VisualCube&& _other);
+
+    void SetInstances(const std::vector<glm::mat4> &_instanceTransforms);
 
-    void Draw(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, int _renderMode = GL_TRIANGLES, const Shader::Material *_material = nullptr) override;
-    void DrawFromMatrix(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, const glm::mat4 &_transformMatrix, int _renderMode = GL_TRIANGLES, const Shader::Material *_material = nullptr) override;
+    [[nodiscard]] int GetInstanceCount() const override;
+    void DrawGeometry(int _renderMode, int _instanceCount = 0) const override;
 };
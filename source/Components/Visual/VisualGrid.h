@@ -19,6 +19,5 @@ public:
 public:
     VisualGrid(int _width, int _height, float _cellSize = 1.0f, glm::vec3 _position = glm::vec3(0.0f), glm::vec3 _rotation = glm::vec3(0.0f), Shader::Material _material = Shader::Material());
 
-    void Draw(const glm::mat4 &viewProjection, const glm::vec3 &_cameraPosition, int _renderMode = GL_LINES, const Shader::Material *_material = nullptr) override;
-    void DrawFromMatrix(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, const glm::mat4 &_transformMatrix, int _renderMode = GL_LINES, const Shader::Material *_material = nullptr) override;
+    [[nodiscard]] glm::mat4 GetModelMatrix() const override;
 };
\ No newline at end of file
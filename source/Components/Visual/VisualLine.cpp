@@ -5,50 +5,19 @@ VisualLine::VisualLine(glm::vec3 _start, glm::vec3 _end, Shader::Material _mater
     position = _start;
     end = _end;
 
-    vertices = {
+    // the end points are baked into the vertices, so lines don't share their geometry
+    SetMesh(std::make_shared<Mesh>(std::vector<float>{
         position.x,
         position.y,
         position.z,
         end.x,
         end.y,
-        end.z};
-
-    indices = {
-        0, 1};
-
-    VisualObject::SetupGlBuffersVerticesWithIndices();
+        end.z}, std::vector<int>{
+        0, 1}, Mesh::Layout::Positions));
 }
 
-void VisualLine::Draw(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, int _renderMode, const Shader::Material *_material)
+glm::mat4 VisualLine::GetModelMatrix() const
 {
-    glm::mat4 model_matrix = glm::mat4(1.0f);
-
-    DrawFromMatrix(_viewProjection, _cameraPosition, model_matrix, _renderMode, _material);
+    // the start & end points are already in world space
+    return glm::mat4(1.0f);
 }
-
-void VisualLine::DrawFromMatrix(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition,
-                                const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material *_material)
-{
-    // bind the vertex array to draw
-    glBindVertexArray(vertex_array_o);
-
-    const Shader::Material *current_material = &material;
-
-    // set the material to use on this frame
-    if (_material != nullptr)
-        current_material = _material;
-
-    current_material->shader->Use();
-    current_material->shader->SetModelMatrix(_transformMatrix);
-    current_material->shader->SetViewProjectionMatrix(_viewProjection);
-
-    current_material->shader->SetFloatFast("u_texture_influence", current_material->texture_influence);
-    current_material->shader->SetVec3("u_color", current_material->color.r, current_material->color.g, current_material->color.b);
-    current_material->shader->SetFloat("u_alpha", current_material->alpha);
-
-    glLineWidth(current_material->line_thickness);
-    glPointSize(current_material->point_size);
-
-    // draw vertices according to their indices
-    glDrawElements(_renderMode, indices.size(), GL_UNSIGNED_INT, nullptr);
-}
\ No newline at end of file
@@ -3,7 +3,10 @@
 #include <memory>
 #include <vector>
 #include "glm/vec3.hpp"
+#include "glm/mat4x4.hpp"
 #include "Components/Shader.h"
+#include "Utility/Bounds.hpp"
+#include "Mesh.h"
 
 class VisualObject
 {
@@ -15,27 +18,42 @@ public:
     Shader::Material material;
 
 protected:
-    // Vertices and indices used by this object
-    // May or may not be used, depending on the implementation
-    std::vector<float> vertices;
-    std::vector<int> indices;
+    // Geometry drawn by this object, possibly shared with other objects (see Mesh::Library)
+    std::shared_ptr<Mesh> mesh;
 
-    // OpenGL buffers
-    GLuint vertex_array_o;
-    GLuint vertex_buffer_o;
-    GLuint element_buffer_o;
+    // Coarser versions of the mesh, drawn instead of it when the object is small on screen
+    struct Lod {
+        std::shared_ptr<Mesh> mesh;
+        float max_screen_size; // drawn when the object's radius is less than this fraction of the view's height
+    };
+
+    std::vector<Lod> lods; // from the finest to the coarsest
+
+    // Bounding volumes of everything this object draws, in its local space (the mesh's bounds, unless the object draws more than it)
+    Bounds bounds;
 
 public:
     explicit VisualObject(glm::vec3 _position = glm::vec3(0.0f), glm::vec3 _rotation = glm::vec3(0.0f), glm::vec3 _scale = glm::vec3(1.0f), Shader::Material _material = Shader::Material());
+    virtual ~VisualObject() = default;
 
-    virtual void Draw(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, int render_mode, const Shader::Material *_material) = 0;
-    virtual void DrawFromMatrix(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material *_material) = 0;
+    // Model matrix built from the transform properties
+    [[nodiscard]] virtual glm::mat4 GetModelMatrix() const;
 
-protected:
-    void SetupGlBuffersVerticesWithIndices();
-    void SetupGlBuffersVerticesNormalsUvsWithIndices();
-    void SetupGlBuffersVerticesUvsWithIndices();
+    [[nodiscard]] const Bounds &GetBounds() const;
 
-    void SetupGlBuffersVerticesNormals();
-    void SetupGlBuffersVerticesNormalsUvs();
+    // Geometry of this object, e.g. to bake it into another one or to draw it indirectly
+    [[nodiscard]] const Mesh &GetMesh() const;
+    [[nodiscard]] const Mesh &GetLodMesh(float _screenSize) const; // the coarsest mesh meant for this screen size (the object's radius as a fraction of the view's height)
+    [[nodiscard]] bool HasLods() const;
+    [[nodiscard]] const std::vector<float> &GetVertices() const;
+    [[nodiscard]] const std::vector<int> &GetIndices() const;
+
+    // Drawing hooks, used by the render queue once it has set up all the state (shader, uniforms, textures & vertex array)
+    [[nodiscard]] GLuint GetVertexArray() const;
+    [[nodiscard]] virtual int GetInstanceCount() const;
+    virtual void DrawGeometry(int _renderMode, int _instanceCount = 0) const;
+
+protected:
+    void SetMesh(std::shared_ptr<Mesh> _mesh);
+    void AddLod(std::shared_ptr<Mesh> _mesh, float _maxScreenSize); // has to be coarser & used for smaller sizes than the previously added ones
 };
@@ -14,14 +14,20 @@ public:
     float radius;
     int subdivisions;
 
+    // Every coarser subdivision level is a level of detail, level n being drawn once the sphere's radius is below LOD_SCREEN_SIZE * 2^n of the view's height
+    // (each level halves the edges, so their projected length stays about the same from one level to the next)
+    constexpr static float LOD_SCREEN_SIZE = 0.02f;
+
+    // Spheres with up to this many subdivisions copy their geometry from an icosphere generated at compile time (see Icosphere.hpp),
+    // the finer ones are generated at runtime
+    constexpr static int COMPILED_SUBDIVISIONS = 3;
+
     explicit VisualSphere(float radius = 1.0f, int subdivisions = 1, glm::vec3 _position = glm::vec3(0.0f), glm::vec3 _rotation = glm::vec3(0.0f), glm::vec3 _scale = glm::vec3(1.0f), Shader::Material _material = Shader::Material());
 
-    void subdivideTriangles();
+    // _coarserLevels, if any, gets the indices of every level before the last one (the icosahedron's first)
+    void subdivideTriangles(std::vector<float> &_vertices, std::vector<int> &_indices, std::vector<std::vector<int>> *_coarserLevels = nullptr);
 
     glm::vec3 normalizeVertice(float vx, float vy, float vz);
     glm::vec3 computeFaceNormals(glm::vec3 v);
     glm::vec2 computeVertexTexture(glm::vec3 v);
-
-    void Draw(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, int _renderMode = GL_TRIANGLES, const Shader::Material *_material = nullptr) override;
-    void DrawFromMatrix(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, const glm::mat4 &_transformMatrix, int _renderMode = GL_TRIANGLES, const Shader::Material *_material = nullptr) override;
 };
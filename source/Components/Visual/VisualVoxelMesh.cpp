@@ -0,0 +1,183 @@
+#include "VisualVoxelMesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include "glm/geometric.hpp"
+
+VisualVoxelMesh::VisualVoxelMesh(const std::vector<Box> &_boxes, float _voxelSize, Shader::Material _material) : VisualObject(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), std::move(_material))
+{
+    voxel_size = _voxelSize;
+
+    std::vector<float> vertices;
+    std::vector<int> indices;
+
+    if (_boxes.empty())
+    {
+        SetMesh(std::make_shared<Mesh>(vertices, indices, Mesh::Layout::PositionsNormalsUvs));
+        return;
+    }
+
+    //grid bounds, in voxels
+    int grid_min[3], grid_max[3];
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        grid_min[axis] = (int)std::lround(_boxes.front().min[axis] / voxel_size);
+        grid_max[axis] = (int)std::lround(_boxes.front().max[axis] / voxel_size);
+
+        for (const auto &box: _boxes)
+        {
+            grid_min[axis] = std::min(grid_min[axis], (int)std::lround(box.min[axis] / voxel_size));
+            grid_max[axis] = std::max(grid_max[axis], (int)std::lround(box.max[axis] / voxel_size));
+        }
+    }
+
+    const int dimensions[3] = { grid_max[0] - grid_min[0], grid_max[1] - grid_min[1], grid_max[2] - grid_min[2] };
+
+    //fills the voxels covered by each box
+    std::vector<bool> voxels(dimensions[0] * dimensions[1] * dimensions[2], false);
+
+    for (const auto &box: _boxes)
+    {
+        int box_min[3], box_max[3];
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            box_min[axis] = (int)std::lround(box.min[axis] / voxel_size) - grid_min[axis];
+            box_max[axis] = (int)std::lround(box.max[axis] / voxel_size) - grid_min[axis];
+        }
+
+        for (int z = box_min[2]; z < box_max[2]; ++z)
+            for (int y = box_min[1]; y < box_max[1]; ++y)
+                for (int x = box_min[0]; x < box_max[0]; ++x)
+                    voxels[(z * dimensions[1] + y) * dimensions[0] + x] = true;
+    }
+
+    GreedyMesh(voxels, dimensions, glm::vec3((float)grid_min[0], (float)grid_min[1], (float)grid_min[2]) * voxel_size, vertices, indices);
+
+    //the meshed shape is unique to this object, so it's not shared through the mesh library
+    SetMesh(std::make_shared<Mesh>(std::move(vertices), std::move(indices), Mesh::Layout::PositionsNormalsUvs));
+}
+
+void VisualVoxelMesh::GreedyMesh(const std::vector<bool> &_voxels, const int _dimensions[3], const glm::vec3 &_origin, std::vector<float> &_vertices, std::vector<int> &_indices) const
+{
+    const auto is_filled = [&_voxels, _dimensions](const int _position[3]) {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (_position[axis] < 0 || _position[axis] >= _dimensions[axis])
+                return false;
+        }
+
+        return (bool)_voxels[(_position[2] * _dimensions[1] + _position[1]) * _dimensions[0] + _position[0]];
+    };
+
+    //one sweep per axis (d), through slices made of the 2 other axes (u & v)
+    for (int d = 0; d < 3; ++d)
+    {
+        const int u = (d + 1) % 3;
+        const int v = (d + 2) % 3;
+
+        //faces looking towards -d, then towards +d
+        for (int direction = -1; direction <= 1; direction += 2)
+        {
+            std::vector<bool> mask(_dimensions[u] * _dimensions[v]);
+
+            for (int slice = 0; slice < _dimensions[d]; ++slice)
+            {
+                //a face is visible if its voxel is filled and the one in front of it is empty
+                for (int j = 0; j < _dimensions[v]; ++j)
+                {
+                    for (int i = 0; i < _dimensions[u]; ++i)
+                    {
+                        int position[3];
+                        position[d] = slice;
+                        position[u] = i;
+                        position[v] = j;
+
+                        int neighbour[3] = { position[0], position[1], position[2] };
+                        neighbour[d] += direction;
+
+                        mask[j * _dimensions[u] + i] = is_filled(position) && !is_filled(neighbour);
+                    }
+                }
+
+                //merges the visible faces into the biggest rectangles possible, first along u then along v
+                for (int j = 0; j < _dimensions[v]; ++j)
+                {
+                    for (int i = 0; i < _dimensions[u];)
+                    {
+                        if (!mask[j * _dimensions[u] + i])
+                        {
+                            ++i;
+                            continue;
+                        }
+
+                        int width = 1;
+                        while (i + width < _dimensions[u] && mask[j * _dimensions[u] + i + width])
+                            ++width;
+
+                        int height = 1;
+                        bool row_is_full = true;
+
+                        while (j + height < _dimensions[v] && row_is_full)
+                        {
+                            for (int k = 0; k < width; ++k)
+                            {
+                                if (!mask[(j + height) * _dimensions[u] + i + k])
+                                {
+                                    row_is_full = false;
+                                    break;
+                                }
+                            }
+
+                            if (row_is_full)
+                                ++height;
+                        }
+
+                        //the merged faces are consumed
+                        for (int l = 0; l < height; ++l)
+                            for (int k = 0; k < width; ++k)
+                                mask[(j + l) * _dimensions[u] + i + k] = false;
+
+                        glm::vec3 corner = glm::vec3(0.0f), side_u = glm::vec3(0.0f), side_v = glm::vec3(0.0f), normal = glm::vec3(0.0f);
+                        corner[d] = (float)(direction > 0 ? slice + 1 : slice);
+                        corner[u] = (float)i;
+                        corner[v] = (float)j;
+                        side_u[u] = (float)width;
+                        side_v[v] = (float)height;
+                        normal[d] = (float)direction;
+
+                        AddQuad(_origin + corner * voxel_size, side_u * voxel_size, side_v * voxel_size, normal, direction < 0, _vertices, _indices);
+
+                        i += width;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void VisualVoxelMesh::AddQuad(const glm::vec3 &_corner, const glm::vec3 &_sideU, const glm::vec3 &_sideV, const glm::vec3 &_normal, bool _flipWinding, std::vector<float> &_vertices, std::vector<int> &_indices)
+{
+    const int first_index = (int)_vertices.size() / 8;
+
+    //uvs are in world units, so that textures keep the same density on merged quads
+    const glm::vec3 corners[4] = { _corner, _corner + _sideU, _corner + _sideU + _sideV, _corner + _sideV };
+    const float uvs[4][2] = { { 0.0f, 0.0f }, { glm::length(_sideU), 0.0f }, { glm::length(_sideU), glm::length(_sideV) }, { 0.0f, glm::length(_sideV) } };
+
+    for (int i = 0; i < 4; ++i)
+    {
+        _vertices.insert(_vertices.end(), {
+            corners[i].x, corners[i].y, corners[i].z,
+            _normal.x, _normal.y, _normal.z,
+            uvs[i][0], uvs[i][1],
+        });
+    }
+
+    //u x v points towards +d, so faces looking towards -d are wound the other way to stay counter-clockwise from the outside
+    if (_flipWinding)
+        _indices.insert(_indices.end(), { first_index, first_index + 2, first_index + 1, first_index, first_index + 3, first_index + 2 });
+    else
+        _indices.insert(_indices.end(), { first_index, first_index + 1, first_index + 2, first_index, first_index + 2, first_index + 3 });
+}
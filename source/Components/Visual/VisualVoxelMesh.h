@@ -0,0 +1,31 @@
+// For information on how this class (and its parent class) work, see VisualObject.h
+
+#pragma once
+
+#include <vector>
+#include "glm/vec3.hpp"
+#include "Components/Shader.h"
+#include "VisualObject.h"
+
+// A shape made of boxes, filled into a grid of same-sized cubes (voxels) and meshed as a single object:
+// faces between two filled voxels are never seen so they're removed, and coplanar neighbouring faces are merged into bigger quads
+class VisualVoxelMesh : public VisualObject
+{
+public:
+    // Axis-aligned box, snapped to the voxel grid when filled in
+    struct Box {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+private:
+    float voxel_size;
+
+public:
+    VisualVoxelMesh(const std::vector<Box> &_boxes, float _voxelSize, Shader::Material _material = Shader::Material());
+
+private:
+    // greedy meshing, comes from: https://0fps.net/2012/06/30/meshing-in-a-minecraft-game/
+    void GreedyMesh(const std::vector<bool> &_voxels, const int _dimensions[3], const glm::vec3 &_origin, std::vector<float> &_vertices, std::vector<int> &_indices) const;
+    static void AddQuad(const glm::vec3 &_corner, const glm::vec3 &_sideU, const glm::vec3 &_sideV, const glm::vec3 &_normal, bool _flipWinding, std::vector<float> &_vertices, std::vector<int> &_indices);
+};
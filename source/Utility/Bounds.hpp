@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+#include "glm/common.hpp"
+#include "glm/geometric.hpp"
+
+// Bounding volumes of an object: an axis-aligned box (AABB) and a sphere enclosing it
+struct Bounds {
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+
+    //bounds of the positions of interleaved vertices (the position being the first 3 floats of each vertex)
+    static Bounds FromVertices(const std::vector<float>& _vertices, int _stride) {
+        Bounds bounds;
+
+        if (_vertices.size() < 3)
+            return bounds;
+
+        bounds.min = bounds.max = glm::vec3(_vertices[0], _vertices[1], _vertices[2]);
+
+        for (size_t i = 0; i + 2 < _vertices.size(); i += _stride) {
+            const glm::vec3 vertex = glm::vec3(_vertices[i], _vertices[i + 1], _vertices[i + 2]);
+
+            bounds.min = glm::min(bounds.min, vertex);
+            bounds.max = glm::max(bounds.max, vertex);
+        }
+
+        //the sphere is centered on the box, but only as big as the farthest vertex (tighter than the box's corners)
+        bounds.center = (bounds.min + bounds.max) * 0.5f;
+
+        for (size_t i = 0; i + 2 < _vertices.size(); i += _stride) {
+            const glm::vec3 vertex = glm::vec3(_vertices[i], _vertices[i + 1], _vertices[i + 2]);
+
+            bounds.radius = std::max(bounds.radius, glm::length(vertex - bounds.center));
+        }
+
+        return bounds;
+    }
+
+    //bounds enclosing both bounds
+    [[nodiscard]] Bounds Merged(const Bounds& _other) const {
+        Bounds bounds;
+
+        bounds.min = glm::min(min, _other.min);
+        bounds.max = glm::max(max, _other.max);
+
+        bounds.center = (bounds.min + bounds.max) * 0.5f;
+        bounds.radius = glm::length(bounds.max - bounds.center);
+
+        return bounds;
+    }
+
+    //bounds of the transformed bounds, comes from: Graphics Gems, "Transforming Axis-Aligned Bounding Boxes" (J. Arvo)
+    [[nodiscard]] Bounds Transformed(const glm::mat4& _transform) const {
+        Bounds bounds;
+
+        const glm::vec3 box_center = (min + max) * 0.5f;
+        const glm::vec3 box_extents = (max - min) * 0.5f;
+
+        const glm::vec3 new_box_center = glm::vec3(_transform * glm::vec4(box_center, 1.0f));
+        glm::vec3 new_box_extents = glm::vec3(0.0f);
+
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j)
+                new_box_extents[i] += std::abs(_transform[j][i]) * box_extents[j];
+        }
+
+        bounds.min = new_box_center - new_box_extents;
+        bounds.max = new_box_center + new_box_extents;
+
+        //the sphere grows with the largest scale of the transform
+        const float max_scale = std::max({ glm::length(glm::vec3(_transform[0])), glm::length(glm::vec3(_transform[1])), glm::length(glm::vec3(_transform[2])) });
+
+        bounds.center = glm::vec3(_transform * glm::vec4(center, 1.0f));
+        bounds.radius = radius * max_scale;
+
+        return bounds;
+    }
+};
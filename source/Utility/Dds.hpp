@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// DirectDraw Surface container, the way the texture cooker stores block compressed textures with their whole mip chain
+// Layout: the magic, the header, then every mip level's blocks from the biggest to the smallest (1x1)
+// from: https://learn.microsoft.com/en-us/windows/win32/direct3ddds/dx-graphics-dds-pguide
+struct Dds {
+    constexpr static uint32_t MAGIC = 0x20534444; // "DDS "
+
+    // four character codes of the formats, little endian
+    constexpr static uint32_t DXT1 = 0x31545844; // "DXT1", BC1: opaque colors, 8 bytes per 4x4 block
+    constexpr static uint32_t DXT5 = 0x35545844; // "DXT5", BC3: BC1 colors + interpolated alpha, 16 bytes per 4x4 block
+
+    // header flags, only the ones the cooker writes
+    constexpr static uint32_t FLAGS_CAPS = 0x1, FLAGS_HEIGHT = 0x2, FLAGS_WIDTH = 0x4, FLAGS_PIXEL_FORMAT = 0x1000, FLAGS_MIPMAP_COUNT = 0x20000, FLAGS_LINEAR_SIZE = 0x80000;
+    constexpr static uint32_t PIXEL_FORMAT_FOUR_CC = 0x4;
+    constexpr static uint32_t CAPS_COMPLEX = 0x8, CAPS_TEXTURE = 0x1000, CAPS_MIPMAP = 0x400000;
+
+    struct PixelFormat {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t four_cc;
+        uint32_t rgb_bit_count;
+        uint32_t r_mask, g_mask, b_mask, a_mask;
+    };
+
+    struct Header {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t height;
+        uint32_t width;
+        uint32_t pitch_or_linear_size; // size of the first level
+        uint32_t depth;
+        uint32_t mipmap_count;
+        uint32_t reserved[11];
+        PixelFormat pixel_format;
+        uint32_t caps, caps2, caps3, caps4;
+        uint32_t reserved2;
+    };
+
+    static_assert(sizeof(PixelFormat) == 32 && sizeof(Header) == 124, "the DDS header has a fixed size");
+
+    constexpr static size_t GetBlockSize(uint32_t _fourCc) {
+        return _fourCc == DXT1 ? 8 : 16;
+    }
+
+    constexpr static size_t GetLevelSize(int _width, int _height, uint32_t _fourCc) {
+        return (size_t)std::max(1, (_width + 3) / 4) * (size_t)std::max(1, (_height + 3) / 4) * GetBlockSize(_fourCc);
+    }
+};
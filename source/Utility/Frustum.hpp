@@ -0,0 +1,61 @@
+#pragma once
+
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+#include "glm/geometric.hpp"
+#include "Bounds.hpp"
+
+// The 6 clipping planes of a view-projection, in world space
+struct Frustum {
+    glm::vec4 planes[6]; //xyz: normal (pointing inside), w: distance
+
+    Frustum() = default;
+
+    //extracts the planes from the rows of the view-projection, comes from: https://www.gamedevs.org/uploads/fast-extraction-viewing-frustum-planes-from-world-view-projection-matrix.pdf
+    explicit Frustum(const glm::mat4& _viewProjection) {
+        const glm::vec4 row_x = glm::vec4(_viewProjection[0][0], _viewProjection[1][0], _viewProjection[2][0], _viewProjection[3][0]);
+        const glm::vec4 row_y = glm::vec4(_viewProjection[0][1], _viewProjection[1][1], _viewProjection[2][1], _viewProjection[3][1]);
+        const glm::vec4 row_z = glm::vec4(_viewProjection[0][2], _viewProjection[1][2], _viewProjection[2][2], _viewProjection[3][2]);
+        const glm::vec4 row_w = glm::vec4(_viewProjection[0][3], _viewProjection[1][3], _viewProjection[2][3], _viewProjection[3][3]);
+
+        planes[0] = row_w + row_x; //left
+        planes[1] = row_w - row_x; //right
+        planes[2] = row_w + row_y; //bottom
+        planes[3] = row_w - row_y; //top
+        planes[4] = row_w + row_z; //near
+        planes[5] = row_w - row_z; //far
+
+        //normalized, so that distances to the planes are in world units
+        for (auto& plane : planes)
+            plane = plane / glm::length(glm::vec3(plane));
+    }
+
+    //conservative: a sphere that's only near a corner of the frustum can still be considered inside
+    [[nodiscard]] bool IntersectsSphere(const glm::vec3& _center, float _radius) const {
+        for (const auto& plane : planes) {
+            if (glm::dot(glm::vec3(plane), _center) + plane.w < -_radius)
+                return false;
+        }
+
+        return true;
+    }
+
+    //conservative as well: a box crossing the frustum's edges outside of it can still be considered inside
+    [[nodiscard]] bool IntersectsBox(const glm::vec3& _min, const glm::vec3& _max) const {
+        for (const auto& plane : planes) {
+            //corner of the box that's the farthest along the plane's normal
+            const glm::vec3 farthest_corner = glm::vec3(plane.x >= 0.0f ? _max.x : _min.x, plane.y >= 0.0f ? _max.y : _min.y, plane.z >= 0.0f ? _max.z : _min.z);
+
+            if (glm::dot(glm::vec3(plane), farthest_corner) + plane.w < 0.0f)
+                return false;
+        }
+
+        return true;
+    }
+
+    //the sphere is tested first, since it's cheaper and rejects most of what's outside
+    [[nodiscard]] bool Intersects(const Bounds& _bounds) const {
+        return IntersectsSphere(_bounds.center, _bounds.radius) && IntersectsBox(_bounds.min, _bounds.max);
+    }
+};
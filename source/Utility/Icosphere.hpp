@@ -0,0 +1,149 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include "Math.hpp"
+#include "VertexCache.hpp"
+
+// Icosphere of radius 1, generated at compile time with all of its subdivision levels up to SUBDIVISIONS
+// Vertices are interleaved as position (3) + normal (3) + uv (2), every level's vertices coming before the ones the next level adds,
+// so level n is drawn with the first GetVertexCount(n) vertices and its own slice of the indices (at GetIndexOffset(n))
+template<int SUBDIVISIONS>
+struct Icosphere {
+    constexpr static int STRIDE = 8;
+
+    // every subdivision splits each triangle in 4, and adds a vertex per edge
+    constexpr static int GetVertexCount(int _level) { return 10 * (1 << (2 * _level)) + 2; }
+    constexpr static int GetIndexCount(int _level) { return 60 * (1 << (2 * _level)); }
+    constexpr static int GetIndexOffset(int _level) { return 20 * ((1 << (2 * _level)) - 1); } // sum of the previous levels' counts
+
+    std::array<float, GetVertexCount(SUBDIVISIONS) * STRIDE> vertices{};
+    std::array<int, GetIndexOffset(SUBDIVISIONS + 1)> indices{};
+
+    // same geometry as VisualSphere's runtime generation, only the triangles' order differs (see below)
+    constexpr static Icosphere Generate() {
+        // why the golden ratio: https://en.wikipedia.org/wiki/Regular_icosahedron
+        constexpr double golden_ratio = 1.61803398874989484820;
+
+        constexpr double corners[12][3] = {
+            { -1, golden_ratio, 0 }, { 1, golden_ratio, 0 }, { -1, -golden_ratio, 0 }, { 1, -golden_ratio, 0 },
+            { 0, -1, golden_ratio }, { 0, 1, golden_ratio }, { 0, -1, -golden_ratio }, { 0, 1, -golden_ratio },
+            { golden_ratio, 0, -1 }, { golden_ratio, 0, 1 }, { -golden_ratio, 0, -1 }, { -golden_ratio, 0, 1 }
+        };
+
+        constexpr int faces[60] = {
+            0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11,
+            1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+            3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9,
+            4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1
+        };
+
+        //positions on the unit sphere
+        std::vector<double> positions;
+
+        const auto push_normalized = [&positions](double _x, double _y, double _z) {
+            const double length = Math::Sqrt(_x * _x + _y * _y + _z * _z);
+
+            positions.push_back(_x / length);
+            positions.push_back(_y / length);
+            positions.push_back(_z / length);
+        };
+
+        for (const auto &corner: corners)
+            push_normalized(corner[0], corner[1], corner[2]);
+
+        //only the icosahedron's triangles are reordered for the vertex cache (running it on every level would take the compiler minutes),
+        //the next levels emit the 4 children of each triangle in the order of their parents, so they keep about the same locality
+        std::vector<std::vector<int>> levels;
+        levels.push_back(VertexCache::OptimizeTriangleOrder(std::vector<int>(faces, faces + 60), 12));
+
+        for (int level = 1; level <= SUBDIVISIONS; ++level) {
+            const std::vector<int> &previous = levels.back();
+            std::vector<int> current;
+
+            //mid points of the edges around each vertex, a vertex having at most 6 neighbours
+            const int previous_vertex_count = (int)positions.size() / 3;
+            std::vector<int> neighbours(previous_vertex_count * 6, -1);
+            std::vector<int> mid_points(previous_vertex_count * 6, -1);
+
+            const auto get_mid_point = [&](int _a, int _b) {
+                int free_slot = -1;
+
+                for (int slot = _a * 6; slot < _a * 6 + 6; ++slot) {
+                    if (neighbours[slot] == _b)
+                        return mid_points[slot];
+
+                    if (neighbours[slot] < 0 && free_slot < 0)
+                        free_slot = slot;
+                }
+
+                push_normalized((positions[_a * 3] + positions[_b * 3]) * 0.5, (positions[_a * 3 + 1] + positions[_b * 3 + 1]) * 0.5, (positions[_a * 3 + 2] + positions[_b * 3 + 2]) * 0.5);
+                const int index = (int)positions.size() / 3 - 1;
+
+                //registered on both ends, since the other triangle of the edge goes through it the other way
+                neighbours[free_slot] = _b;
+                mid_points[free_slot] = index;
+
+                for (int slot = _b * 6; slot < _b * 6 + 6; ++slot) {
+                    if (neighbours[slot] < 0) {
+                        neighbours[slot] = _a;
+                        mid_points[slot] = index;
+                        break;
+                    }
+                }
+
+                return index;
+            };
+
+            for (int i = 0; i < (int)previous.size(); i += 3) {
+                const int i1 = previous[i];
+                const int i2 = previous[i + 1];
+                const int i3 = previous[i + 2];
+
+                const int i12 = get_mid_point(i1, i2);
+                const int i23 = get_mid_point(i2, i3);
+                const int i31 = get_mid_point(i3, i1);
+
+                for (int index: { i1, i12, i31, i12, i2, i23, i12, i23, i31, i31, i23, i3 })
+                    current.push_back(index);
+            }
+
+            levels.push_back(current);
+        }
+
+        //vertices in the order the levels use them (coarsest first)
+        std::vector<float> unit_positions(positions.begin(), positions.end());
+        std::vector<std::vector<int>*> level_pointers;
+
+        for (auto &level_indices: levels)
+            level_pointers.push_back(&level_indices);
+
+        VertexCache::OptimizeVertexOrder(unit_positions, 3, level_pointers);
+
+        Icosphere icosphere;
+
+        for (int i = 0; i < GetVertexCount(SUBDIVISIONS); ++i) {
+            const float x = unit_positions[i * 3];
+            const float y = unit_positions[i * 3 + 1];
+            const float z = unit_positions[i * 3 + 2];
+
+            //the normal of a unit sphere is its position, and the uvs follow VisualSphere::computeVertexTexture (whose normal points inwards)
+            const float vertex[STRIDE] = {
+                x, y, z,
+                x, y, z,
+                (float)(0.5 + (Math::Atan2(-z, -x) / 2 * 3.1451f)),
+                (float)(0.5 + (Math::Asin(-y) / 3.1451f)),
+            };
+
+            for (int j = 0; j < STRIDE; ++j)
+                icosphere.vertices[i * STRIDE + j] = vertex[j];
+        }
+
+        for (int level = 0; level <= SUBDIVISIONS; ++level) {
+            for (int i = 0; i < GetIndexCount(level); ++i)
+                icosphere.indices[GetIndexOffset(level) + i] = levels[level][i];
+        }
+
+        return icosphere;
+    }
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// A whole file mapped read-only in memory, its pages are only read from the disk when they're touched
+// Stays mapped for as long as the object exists
+class MappedFile {
+private:
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+
+#ifdef _WIN32
+    HANDLE file_handle = INVALID_HANDLE_VALUE;
+    HANDLE mapping_handle = nullptr;
+#endif
+
+public:
+    explicit MappedFile(const std::string &_path) {
+#ifdef _WIN32
+        file_handle = CreateFileA(_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_handle == INVALID_HANDLE_VALUE)
+            return;
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0)
+            return;
+
+        mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_handle == nullptr)
+            return;
+
+        data = (const uint8_t *)MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+        size = data != nullptr ? (size_t)file_size.QuadPart : 0;
+#else
+        const int file_descriptor = open(_path.c_str(), O_RDONLY);
+        if (file_descriptor < 0)
+            return;
+
+        struct stat file_stats{};
+        if (fstat(file_descriptor, &file_stats) == 0 && file_stats.st_size > 0) {
+            void *mapping = mmap(nullptr, (size_t)file_stats.st_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+
+            if (mapping != MAP_FAILED) {
+                data = (const uint8_t *)mapping;
+                size = (size_t)file_stats.st_size;
+            }
+        }
+
+        //the mapping keeps the file alive on its own
+        close(file_descriptor);
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (data != nullptr)
+            UnmapViewOfFile(data);
+        if (mapping_handle != nullptr)
+            CloseHandle(mapping_handle);
+        if (file_handle != INVALID_HANDLE_VALUE)
+            CloseHandle(file_handle);
+#else
+        if (data != nullptr)
+            munmap((void *)data, size);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // null if the file couldn't be opened or is empty
+    [[nodiscard]] const uint8_t *GetData() const { return data; }
+    [[nodiscard]] size_t GetSize() const { return size; }
+    [[nodiscard]] bool IsValid() const { return data != nullptr; }
+};
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cmath>
+#include <type_traits>
+
 struct Math {
     constexpr static float PI = 3.1415f;
 
@@ -12,4 +15,80 @@ struct Math {
         // Perform the mapping
         return (value - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
     }
-};
\ No newline at end of file
+
+    // The std functions below can't be evaluated at compile time (before C++26), these can, and call the std ones at runtime
+
+    constexpr static double Sqrt(double value)
+    {
+        if (!std::is_constant_evaluated())
+            return std::sqrt(value);
+
+        if (value <= 0.0)
+            return 0.0;
+
+        // Newton's method, until the estimate stops moving
+        double estimate = value > 1.0 ? value : 1.0;
+        double previous = 0.0;
+
+        while (estimate != previous) {
+            previous = estimate;
+            estimate = 0.5 * (estimate + value / estimate);
+
+            if (estimate >= previous)
+                break;
+        }
+
+        return estimate;
+    }
+
+    constexpr static double Atan(double value)
+    {
+        if (!std::is_constant_evaluated())
+            return std::atan(value);
+
+        constexpr double half_pi = 1.57079632679489661923;
+        constexpr double quarter_pi = 0.78539816339744830962;
+
+        // reduces the value to [-tan(pi/8), tan(pi/8)], where the series converges quickly
+        if (value < 0.0)
+            return -Atan(-value);
+        if (value > 1.0)
+            return half_pi - Atan(1.0 / value);
+        if (value > 0.41421356237309504880)
+            return quarter_pi + Atan((value - 1.0) / (value + 1.0));
+
+        // Taylor series: x - x^3/3 + x^5/5 - ...
+        double result = 0.0;
+        double term = value;
+
+        for (int i = 0; i < 24; ++i) {
+            result += (i % 2 == 0 ? term : -term) / (2 * i + 1);
+            term *= value * value;
+        }
+
+        return result;
+    }
+
+    constexpr static double Atan2(double y, double x)
+    {
+        if (!std::is_constant_evaluated())
+            return std::atan2(y, x);
+
+        constexpr double pi = 3.14159265358979323846;
+
+        if (x > 0.0)
+            return Atan(y / x);
+        if (x < 0.0)
+            return y >= 0.0 ? Atan(y / x) + pi : Atan(y / x) - pi;
+
+        return y > 0.0 ? pi / 2.0 : (y < 0.0 ? -pi / 2.0 : 0.0);
+    }
+
+    constexpr static double Asin(double value)
+    {
+        if (!std::is_constant_evaluated())
+            return std::asin(value);
+
+        return Atan2(value, Sqrt(1.0 - value * value));
+    }
+};
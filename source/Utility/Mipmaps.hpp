@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Mip chain of an RGBA image (8 bits per channel), built on the CPU with a box filter
+struct Mipmaps {
+    struct Level {
+        int width = 0, height = 0;
+        std::vector<uint8_t> pixels; // RGBA, row by row
+    };
+
+    // next level of the chain, each pixel being the average of (up to) 4 pixels of the previous one
+    static Level Downsample(const Level &_level) {
+        Level next;
+        next.width = std::max(1, _level.width / 2);
+        next.height = std::max(1, _level.height / 2);
+        next.pixels.resize((size_t)next.width * next.height * 4);
+
+        for (int y = 0; y < next.height; ++y) {
+            for (int x = 0; x < next.width; ++x) {
+                //clamped, for the levels where only one of the sizes still shrinks
+                const int x0 = std::min(x * 2, _level.width - 1), x1 = std::min(x * 2 + 1, _level.width - 1);
+                const int y0 = std::min(y * 2, _level.height - 1), y1 = std::min(y * 2 + 1, _level.height - 1);
+
+                for (int c = 0; c < 4; ++c) {
+                    const int sum = _level.pixels[((size_t)y0 * _level.width + x0) * 4 + c] + _level.pixels[((size_t)y0 * _level.width + x1) * 4 + c] +
+                                    _level.pixels[((size_t)y1 * _level.width + x0) * 4 + c] + _level.pixels[((size_t)y1 * _level.width + x1) * 4 + c];
+
+                    next.pixels[((size_t)y * next.width + x) * 4 + c] = (uint8_t)((sum + 2) / 4);
+                }
+            }
+        }
+
+        return next;
+    }
+
+    // levels down to 1x1
+    static int GetLevelCount(int _width, int _height) {
+        int count = 1;
+
+        while (_width > 1 || _height > 1) {
+            _width = std::max(1, _width / 2);
+            _height = std::max(1, _height / 2);
+            count++;
+        }
+
+        return count;
+    }
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running queued jobs, for CPU work that shouldn't block the GL thread (e.g. decoding images)
+// The jobs must not touch the GL context, it's only current on the main thread
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> jobs;
+
+    std::mutex jobs_mutex;
+    std::condition_variable jobs_available;
+    bool stopping = false;
+
+public:
+    // one thread is left for the GL thread by default
+    explicit ThreadPool(int _threadCount = std::max(1, (int)std::thread::hardware_concurrency() - 1)) {
+        for (int i = 0; i < _threadCount; ++i) {
+            workers.emplace_back([this]() {
+                while (true) {
+                    std::function<void()> job;
+
+                    {
+                        std::unique_lock lock(jobs_mutex);
+                        jobs_available.wait(lock, [this]() { return stopping || !jobs.empty(); });
+
+                        if (stopping && jobs.empty())
+                            return;
+
+                        job = std::move(jobs.front());
+                        jobs.pop();
+                    }
+
+                    job();
+                }
+            });
+        }
+    }
+
+    // the queued jobs are finished before the workers stop
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(jobs_mutex);
+            stopping = true;
+        }
+
+        jobs_available.notify_all();
+
+        for (auto &worker: workers)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void Enqueue(std::function<void()> _job) {
+        {
+            std::lock_guard lock(jobs_mutex);
+            jobs.push(std::move(_job));
+        }
+
+        jobs_available.notify_one();
+    }
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cmath>
 #include "glm/vec3.hpp"
 
 struct Transforms {
@@ -15,4 +16,21 @@ struct Transforms {
 
         return result;
     }
+
+    //true if the transform keeps axis-aligned boxes axis-aligned (only 90 degree rotations, scales & translations)
+    static bool IsAxisAligned(const glm::mat4& _matrix, float _epsilon = 0.0001f) {
+        for (int column = 0; column < 3; ++column) {
+            int non_zero_count = 0;
+
+            for (int row = 0; row < 3; ++row) {
+                if (std::abs(_matrix[column][row]) > _epsilon)
+                    non_zero_count++;
+            }
+
+            if (non_zero_count != 1)
+                return false;
+        }
+
+        return true;
+    }
 };
\ No newline at end of file
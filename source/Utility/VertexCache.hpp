@@ -0,0 +1,167 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+#include "Math.hpp"
+
+// Reordering of indexed triangles, so that the GPU's post-transform vertex cache re-runs the vertex shader as rarely as possible
+// Everything is constexpr, so that generated meshes can be optimized at compile time as well
+struct VertexCache {
+    static constexpr int CACHE_SIZE = 32; // simulated cache, an LRU list of vertex indices
+
+    //greedy triangle reordering, comes from: https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html (T. Forsyth, "Linear-Speed Vertex Cache Optimisation")
+    //the next triangle is always the one whose vertices score the most, i.e. are the most recently used and have the fewest triangles left
+    constexpr static std::vector<int> OptimizeTriangleOrder(const std::vector<int>& _indices, int _vertexCount) {
+        const int triangle_count = (int)_indices.size() / 3;
+
+        //triangles using each vertex, packed in a single array (vertex i's triangles start at triangle_offsets[i])
+        std::vector<int> valences(_vertexCount, 0);
+        for (int index : _indices)
+            valences[index]++;
+
+        std::vector<int> triangle_offsets(_vertexCount + 1, 0);
+        for (int i = 0; i < _vertexCount; ++i)
+            triangle_offsets[i + 1] = triangle_offsets[i] + valences[i];
+
+        std::vector<int> vertex_triangles(_indices.size());
+        std::vector<int> filled(_vertexCount, 0);
+        for (int i = 0; i < (int)_indices.size(); ++i) {
+            const int vertex = _indices[i];
+            vertex_triangles[triangle_offsets[vertex] + filled[vertex]++] = i / 3;
+        }
+
+        std::vector<int> cache_positions(_vertexCount, -1);
+        std::vector<float> vertex_scores(_vertexCount);
+        for (int i = 0; i < _vertexCount; ++i)
+            vertex_scores[i] = VertexScore(cache_positions[i], valences[i]);
+
+        std::vector<float> triangle_scores(triangle_count);
+        for (int i = 0; i < triangle_count; ++i)
+            triangle_scores[i] = vertex_scores[_indices[i * 3]] + vertex_scores[_indices[i * 3 + 1]] + vertex_scores[_indices[i * 3 + 2]];
+
+        std::vector<bool> emitted(triangle_count, false);
+        std::vector<int> cache;
+        std::vector<int> result;
+        result.reserve(_indices.size());
+
+        int next_unemitted = 0; //fallback scan position, when none of the cached vertices has a triangle left
+
+        for (int emitted_count = 0; emitted_count < triangle_count; ++emitted_count) {
+            //best triangle among the ones using the cached vertices
+            int best_triangle = -1;
+            float best_score = -1.0f;
+
+            for (int vertex : cache) {
+                for (int j = triangle_offsets[vertex]; j < triangle_offsets[vertex + 1]; ++j) {
+                    const int triangle = vertex_triangles[j];
+
+                    if (!emitted[triangle] && triangle_scores[triangle] > best_score) {
+                        best_score = triangle_scores[triangle];
+                        best_triangle = triangle;
+                    }
+                }
+            }
+
+            if (best_triangle < 0) {
+                while (emitted[next_unemitted])
+                    next_unemitted++;
+
+                best_triangle = next_unemitted;
+            }
+
+            emitted[best_triangle] = true;
+
+            //the triangle's vertices move to the front of the cache, and one triangle less uses them
+            for (int k = 0; k < 3; ++k) {
+                const int vertex = _indices[best_triangle * 3 + k];
+                result.push_back(vertex);
+
+                for (int j = 0; j < (int)cache.size(); ++j) {
+                    if (cache[j] == vertex) {
+                        cache.erase(cache.begin() + j);
+                        break;
+                    }
+                }
+
+                cache.insert(cache.begin(), vertex);
+                valences[vertex]--;
+            }
+
+            //vertices pushed out of the cache aren't scored as cached anymore
+            for (int j = CACHE_SIZE; j < (int)cache.size(); ++j)
+                cache_positions[cache[j]] = -1;
+
+            if ((int)cache.size() > CACHE_SIZE)
+                cache.resize(CACHE_SIZE);
+
+            //only the cached vertices' scores changed, and with them the scores of their triangles
+            for (int j = 0; j < (int)cache.size(); ++j) {
+                cache_positions[cache[j]] = j;
+                vertex_scores[cache[j]] = VertexScore(j, valences[cache[j]]);
+            }
+
+            for (int vertex : cache) {
+                for (int j = triangle_offsets[vertex]; j < triangle_offsets[vertex + 1]; ++j) {
+                    const int triangle = vertex_triangles[j];
+
+                    if (!emitted[triangle])
+                        triangle_scores[triangle] = vertex_scores[_indices[triangle * 3]] + vertex_scores[_indices[triangle * 3 + 1]] + vertex_scores[_indices[triangle * 3 + 2]];
+                }
+            }
+        }
+
+        return result;
+    }
+
+    //renumbers the vertices in the order the triangles first use them, so that the vertex fetches walk through memory (unused vertices are dropped)
+    constexpr static void OptimizeVertexOrder(std::vector<float>& _vertices, int _stride, std::vector<int>& _indices) {
+        OptimizeVertexOrder(_vertices, _stride, std::vector<std::vector<int>*>{ &_indices });
+    }
+
+    //same, for several index lists drawing the same vertices (e.g. levels of detail): the vertices of the first lists come first
+    constexpr static void OptimizeVertexOrder(std::vector<float>& _vertices, int _stride, const std::vector<std::vector<int>*>& _indexLists) {
+        const int vertex_count = (int)_vertices.size() / _stride;
+
+        std::vector<int> remap(vertex_count, -1);
+        std::vector<float> vertices;
+        vertices.reserve(_vertices.size());
+
+        for (std::vector<int>* indices : _indexLists) {
+            for (int& index : *indices) {
+                if (remap[index] < 0) {
+                    remap[index] = (int)vertices.size() / _stride;
+                    vertices.insert(vertices.end(), _vertices.begin() + index * _stride, _vertices.begin() + (index + 1) * _stride);
+                }
+
+                index = remap[index];
+            }
+        }
+
+        _vertices = std::move(vertices);
+    }
+
+private:
+    //score of a vertex: the constants are the ones from the paper
+    constexpr static float VertexScore(int _cachePosition, int _remainingValence) {
+        //no triangle left to draw with this vertex
+        if (_remainingValence == 0)
+            return -1.0f;
+
+        float score = 0.0f;
+
+        if (_cachePosition >= 0) {
+            //the last triangle's 3 vertices score the same, so that its neighbours don't get preferred over one another
+            if (_cachePosition < 3) {
+                score = 0.75f;
+            } else {
+                const float position = 1.0f - (float)(_cachePosition - 3) / (float)(CACHE_SIZE - 3);
+                score = position * (float)Math::Sqrt(position); // position^1.5
+            }
+        }
+
+        //vertices with few triangles left are prioritized, so that they don't end up alone
+        score += 2.0f / (float)Math::Sqrt(_remainingValence); // 2 * valence^-0.5
+
+        return score;
+    }
+};
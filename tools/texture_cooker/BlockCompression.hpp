@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+
+// CPU encoders of 4x4 pixel blocks (RGBA, 8 bits per channel, row by row) into the S3TC formats
+// Endpoints come from the block's bounding box, flipped along the diagonal its colors actually follow, then inset a little
+// from: J.M.P. van Waveren, "Real-Time DXT Compression" (2006)
+struct BlockCompression {
+    using Block = std::array<uint8_t, 16 * 4>;
+
+    // BC1 (DXT1): 2 RGB565 endpoints + 2 bits per pixel, always in 4 colors mode (no transparent pixels)
+    static void EncodeBc1(const Block &_block, uint8_t *_output) {
+        std::array<int, 3> min_color = { 255, 255, 255 };
+        std::array<int, 3> max_color = { 0, 0, 0 };
+
+        for (int i = 0; i < 16; ++i) {
+            for (int c = 0; c < 3; ++c) {
+                min_color[c] = std::min(min_color[c], (int)_block[i * 4 + c]);
+                max_color[c] = std::max(max_color[c], (int)_block[i * 4 + c]);
+            }
+        }
+
+        //the box's diagonal always goes from min to max in red, green & blue, which is wrong for colors that go down in one of them while going up in the others
+        std::array<int, 3> center;
+        for (int c = 0; c < 3; ++c)
+            center[c] = (min_color[c] + max_color[c]) / 2;
+
+        int covariance_rg = 0, covariance_rb = 0;
+        for (int i = 0; i < 16; ++i) {
+            const int r = _block[i * 4] - center[0];
+            covariance_rg += r * (_block[i * 4 + 1] - center[1]);
+            covariance_rb += r * (_block[i * 4 + 2] - center[2]);
+        }
+
+        if (covariance_rg < 0)
+            std::swap(min_color[1], max_color[1]);
+        if (covariance_rb < 0)
+            std::swap(min_color[2], max_color[2]);
+
+        //inset by 1/16 of the range, so that the endpoints aren't wasted on outliers
+        for (int c = 0; c < 3; ++c) {
+            const int inset = (max_color[c] - min_color[c]) / 16;
+            min_color[c] = std::clamp(min_color[c] + inset, 0, 255);
+            max_color[c] = std::clamp(max_color[c] - inset, 0, 255);
+        }
+
+        uint16_t color0 = ToRgb565(max_color);
+        uint16_t color1 = ToRgb565(min_color);
+
+        //the 4 colors mode needs color0 > color1 (the indices are picked afterwards, against the swapped endpoints)
+        if (color0 < color1)
+            std::swap(color0, color1);
+
+        uint32_t indices = 0;
+
+        if (color0 != color1) {
+            const auto end0 = FromRgb565(color0);
+            const auto end1 = FromRgb565(color1);
+
+            std::array<std::array<int, 3>, 4> palette;
+            for (int c = 0; c < 3; ++c) {
+                palette[0][c] = end0[c];
+                palette[1][c] = end1[c];
+                palette[2][c] = (2 * end0[c] + end1[c]) / 3;
+                palette[3][c] = (end0[c] + 2 * end1[c]) / 3;
+            }
+
+            for (int i = 0; i < 16; ++i) {
+                int best_index = 0;
+                int best_distance = INT32_MAX;
+
+                for (int p = 0; p < 4; ++p) {
+                    int distance = 0;
+                    for (int c = 0; c < 3; ++c) {
+                        const int delta = _block[i * 4 + c] - palette[p][c];
+                        distance += delta * delta;
+                    }
+
+                    if (distance < best_distance) {
+                        best_distance = distance;
+                        best_index = p;
+                    }
+                }
+
+                indices |= (uint32_t)best_index << (i * 2);
+            }
+        }
+
+        _output[0] = (uint8_t)(color0 & 0xFF);
+        _output[1] = (uint8_t)(color0 >> 8);
+        _output[2] = (uint8_t)(color1 & 0xFF);
+        _output[3] = (uint8_t)(color1 >> 8);
+
+        for (int i = 0; i < 4; ++i)
+            _output[4 + i] = (uint8_t)(indices >> (i * 8));
+    }
+
+    // BC3 (DXT5): an 8 values alpha block (2 endpoints + 3 bits per pixel), then a BC1 color block
+    static void EncodeBc3(const Block &_block, uint8_t *_output) {
+        int min_alpha = 255, max_alpha = 0;
+
+        for (int i = 0; i < 16; ++i) {
+            min_alpha = std::min(min_alpha, (int)_block[i * 4 + 3]);
+            max_alpha = std::max(max_alpha, (int)_block[i * 4 + 3]);
+        }
+
+        uint64_t indices = 0;
+
+        //alpha0 > alpha1 selects the 8 values mode: both endpoints & 6 values between them
+        if (max_alpha != min_alpha) {
+            std::array<int, 8> palette = { max_alpha, min_alpha };
+            for (int p = 1; p < 7; ++p)
+                palette[p + 1] = ((7 - p) * max_alpha + p * min_alpha) / 7;
+
+            for (int i = 0; i < 16; ++i) {
+                int best_index = 0;
+                int best_distance = INT32_MAX;
+
+                for (int p = 0; p < 8; ++p) {
+                    const int distance = std::abs(_block[i * 4 + 3] - palette[p]);
+
+                    if (distance < best_distance) {
+                        best_distance = distance;
+                        best_index = p;
+                    }
+                }
+
+                indices |= (uint64_t)best_index << (i * 3);
+            }
+        }
+
+        _output[0] = (uint8_t)max_alpha;
+        _output[1] = (uint8_t)min_alpha;
+
+        for (int i = 0; i < 6; ++i)
+            _output[2 + i] = (uint8_t)(indices >> (i * 8));
+
+        EncodeBc1(_block, _output + 8);
+    }
+
+private:
+    static uint16_t ToRgb565(const std::array<int, 3> &_color) {
+        return (uint16_t)(((_color[0] * 31 + 127) / 255) << 11 | ((_color[1] * 63 + 127) / 255) << 5 | ((_color[2] * 31 + 127) / 255));
+    }
+
+    static std::array<int, 3> FromRgb565(uint16_t _color) {
+        const int r = (_color >> 11) & 31;
+        const int g = (_color >> 5) & 63;
+        const int b = _color & 31;
+
+        //the high bits are replicated in the low ones, like the hardware does
+        return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+    }
+};
@@ -0,0 +1,106 @@
+// Offline texture cooker: decodes an image, builds its whole mip chain & block compresses every level into a DDS file
+// Usage: texture_cooker <input image> <output .dds>
+// Images with an alpha channel are stored as BC3 (DXT5), the others as BC1 (DXT1)
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include "stb_image.h"
+#include "Utility/Dds.hpp"
+#include "Utility/Mipmaps.hpp"
+#include "BlockCompression.hpp"
+
+// blocks of the level, row by row (the blocks going over the edges repeat the last row & column)
+static void Compress(const Mipmaps::Level &_image, uint32_t _fourCc, std::vector<uint8_t> &_output) {
+    const size_t block_size = Dds::GetBlockSize(_fourCc);
+
+    for (int block_y = 0; block_y < _image.height; block_y += 4) {
+        for (int block_x = 0; block_x < _image.width; block_x += 4) {
+            BlockCompression::Block block;
+
+            for (int i = 0; i < 16; ++i) {
+                const int x = std::min(block_x + i % 4, _image.width - 1);
+                const int y = std::min(block_y + i / 4, _image.height - 1);
+
+                std::memcpy(&block[i * 4], &_image.pixels[((size_t)y * _image.width + x) * 4], 4);
+            }
+
+            const size_t offset = _output.size();
+            _output.resize(offset + block_size);
+
+            if (_fourCc == Dds::DXT1)
+                BlockCompression::EncodeBc1(block, &_output[offset]);
+            else
+                BlockCompression::EncodeBc3(block, &_output[offset]);
+        }
+    }
+}
+
+int main(int _argc, char **_argv) {
+    if (_argc != 3) {
+        std::cerr << "Usage: texture_cooker <input image> <output .dds>" << std::endl;
+        return 1;
+    }
+
+    const std::string input_path = _argv[1];
+    const std::filesystem::path output_path = _argv[2];
+
+    Mipmaps::Level image;
+    int channels = 0;
+
+    //every level is built from RGBA pixels, whatever the file has
+    uint8_t *data = stbi_load(input_path.c_str(), &image.width, &image.height, &channels, 4);
+    if (!data) {
+        std::cerr << "Error::TextureCooker -> Could not load texture file: " << input_path << std::endl;
+        return 1;
+    }
+
+    image.pixels.assign(data, data + (size_t)image.width * image.height * 4);
+    stbi_image_free(data);
+
+    const bool has_alpha = channels == 2 || channels == 4;
+    const uint32_t four_cc = has_alpha ? Dds::DXT5 : Dds::DXT1;
+    const int width = image.width, height = image.height;
+    const int mipmap_count = Mipmaps::GetLevelCount(width, height);
+
+    std::vector<uint8_t> levels;
+
+    for (int level = 0; level < mipmap_count; ++level) {
+        Compress(image, four_cc, levels);
+
+        if (level + 1 < mipmap_count)
+            image = Mipmaps::Downsample(image);
+    }
+
+    Dds::Header header = {};
+    header.size = sizeof(Dds::Header);
+    header.flags = Dds::FLAGS_CAPS | Dds::FLAGS_HEIGHT | Dds::FLAGS_WIDTH | Dds::FLAGS_PIXEL_FORMAT | Dds::FLAGS_MIPMAP_COUNT | Dds::FLAGS_LINEAR_SIZE;
+    header.width = (uint32_t)width;
+    header.height = (uint32_t)height;
+    header.pitch_or_linear_size = (uint32_t)Dds::GetLevelSize(width, height, four_cc);
+    header.mipmap_count = (uint32_t)mipmap_count;
+    header.pixel_format.size = sizeof(Dds::PixelFormat);
+    header.pixel_format.flags = Dds::PIXEL_FORMAT_FOUR_CC;
+    header.pixel_format.four_cc = four_cc;
+    header.caps = Dds::CAPS_TEXTURE | Dds::CAPS_COMPLEX | Dds::CAPS_MIPMAP;
+
+    if (output_path.has_parent_path())
+        std::filesystem::create_directories(output_path.parent_path());
+
+    std::ofstream file(output_path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Error::TextureCooker -> Could not write file: " << output_path.string() << std::endl;
+        return 1;
+    }
+
+    file.write((const char *)&Dds::MAGIC, sizeof(Dds::MAGIC));
+    file.write((const char *)&header, sizeof(Dds::Header));
+    file.write((const char *)levels.data(), (std::streamsize)levels.size());
+
+    std::cout << "INFO -> Cooked " << input_path << " (" << header.width << "x" << header.height << ", " << mipmap_count << " levels, "
+              << (has_alpha ? "BC3" : "BC1") << ") into " << output_path.string() << std::endl;
+
+    return 0;
+}